@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <thread>
 
 #include <fhttp/env.h>
 
@@ -18,6 +19,8 @@ struct server_config {
     uint16_t app_port;
     std::string app_host;
     size_t workers { 256 };
+    /// one io_context + acceptor per worker, meant to be used with workers == number of cores
+    bool sharded { false };
     size_t graceful_shutdown_seconds { 1 };
 
     std::string mysql_connection_string { "mysql://localhost:3306" };
@@ -34,5 +37,10 @@ struct server_config {
     {
         app_port = fhttp::get_env<uint16_t>("app_port", 11111);
         app_host = fhttp::get_env<std::string>("app_host", "127.0.0.1");
+        sharded = fhttp::get_env<bool>("app_sharded", false);
+
+        if (sharded) {
+            workers = std::thread::hardware_concurrency();
+        }
     }
 };
@@ -14,13 +14,19 @@ namespace example_views {
 
 /// @brief Create base of our handlers with the server configuration
 struct handler_with_metrics: fhttp::http_handler<server_config, example_states::views_shared_state> {
+    /// Headers our handlers read, the parser doesn't store any other, handler reading some
+    /// header has to declare its own `request_headers`
+    static constexpr std::array<std::string_view, 0> request_headers { };
+
     example_states::fake_prometheus_manager& prometheus_manager;
 
     handler_with_metrics(const server_config& config, example_states::views_shared_state& state)
         : fhttp::http_handler<server_config, example_states::views_shared_state>(config, state)
         , prometheus_manager(std::get<example_states::fake_prometheus_manager>(state)) {}
 
-    void evaluate_request(fhttp::handler_context& ctx, fhttp::request<std::string>& req, fhttp::response<std::string>& res) {
+    /// @brief Works for both owned requests and request views, so view handlers don't need a copy of the request
+    template <typename request_t>
+    void evaluate_request(fhttp::handler_context& ctx, request_t& req, fhttp::response<std::string>& res) {
         using super = fhttp::http_handler<server_config, example_states::views_shared_state>;
         super::evaluate_request(ctx, req, res);
         prometheus_manager.increment_request_count(req.path, fhttp::method_to_string(req.method), res.status_code);
@@ -64,6 +70,38 @@ struct profile_post_handler: public base_handler {
     }
 };
 
+/// @brief Path parameters come as a typed data_pack, string parameters are views of the request path
+struct profile_get_handler: public base_handler {
+    constexpr static const char* description = "Get profile by name";
+
+    example_states::fake_sql_manager& sql_manager;
+
+    using request_t = fhttp::request<std::string, void, example_fields::profile_path>;
+    using response_body_t = example_fields::v1::json_response<example_fields::profile>;
+
+    profile_get_handler(const server_config& config, example_states::views_shared_state& state)
+        : base_handler(config, state)
+        , sql_manager(std::get<example_states::fake_sql_manager>(state)) {}
+
+    void handle(const request_t& request, fhttp::response<response_body_t>& response) {
+        const auto user = sql_manager.create_profile(std::string { request.path_params.get<example_fields::path::name>() });
+
+        if (!user) {
+            response.status_code = fhttp::STATUS_CODE_NOT_FOUND;
+            response.body->set<example_fields::status>(fhttp::STATUS_CODE_NOT_FOUND);
+            return;
+        }
+
+        auto& result = response.body->get<example_fields::profile>();
+
+        result.set<example_fields::name>(user->name);
+        result.set<example_fields::email>(user->email);
+
+        response.headers[fhttp::HEADER_CONTENT_TYPE] = "application/json";
+        response.body->set<example_fields::status>(fhttp::STATUS_CODE_OK);
+    }
+};
+
 struct get_all_profiles_handler: public base_handler {
     constexpr static const char* description = "Get all profiles";
 
@@ -102,6 +140,42 @@ struct get_all_profiles_handler: public base_handler {
     }
 };
 
+/// @brief Profiles are sent one JSON document per line as they are "read from the database", first line 
+/// goes out before the rest is produced and the next one is produced only after the previous one was sent
+struct export_profiles_handler: public base_handler {
+    constexpr static const char* description = "Export all profiles as newline delimited JSON";
+
+    example_states::fake_sql_manager& sql_manager;
+
+    export_profiles_handler(const server_config& config, example_states::views_shared_state& state)
+        : base_handler(config, state)
+        , sql_manager(std::get<example_states::fake_sql_manager>(state)) {}
+
+    void handle(const fhttp::request<std::string, example_fields::export_query>& request, fhttp::response<fhttp::response_stream>& response) {
+        auto users = std::make_shared<std::vector<example_states::fake_sql_manager::profile>>(sql_manager.get_all_profiles());
+
+        if (const auto limit = request.query_params.get<example_fields::query::limit>(); limit > 0 and static_cast<std::size_t>(limit) < users->size()) {
+            users->resize(static_cast<std::size_t>(limit));
+        }
+
+        response.headers[fhttp::HEADER_CONTENT_TYPE] = "application/x-ndjson";
+        response.body.producer = [users, index = std::size_t { 0 }] (std::string& out) mutable {
+            if (index == users->size()) {
+                return false;
+            }
+
+            example_fields::profile_data row;
+            row.set<example_fields::name>((*users)[index].name);
+            row.set<example_fields::email>((*users)[index].email);
+
+            fhttp::datalib::serialization::write_json(out, row);
+            out.push_back('\n');
+
+            return ++index < users->size();
+        };
+    }
+};
+
 struct echo_handler: public base_handler {
     using request_t = fhttp::request<fhttp::json<example_fields::echo_request>>;
 
@@ -116,8 +190,9 @@ struct echo_handler: public base_handler {
     }
 };
 
+/// @brief Request is just a view of the connection's read buffer, nothing gets copied out of it
 struct hello_handler: public base_handler {
-    using request_t = fhttp::request<std::string>;
+    using request_t = fhttp::request_view;
 
     constexpr static const char* description = "Echo handler";
 
@@ -130,46 +205,21 @@ struct hello_handler: public base_handler {
     }
 };
 
-struct static_files_handler: public base_handler {
-    static_files_handler(const server_config& config, example_states::views_shared_state& state)
-        : base_handler(config, state) {}
-
-    constexpr static const char* description = "Static files handler";
+/// @brief Body is not buffered in memory as a whole, it's kept in a temporary file once it gets big,
+/// handler can also define `static void prepare_body(const fhttp::request<std::string>&, fhttp::streaming_body&)`
+/// and consume the chunks directly with `body.on_chunk(...)` (static, the handler instance doesn't exist yet)
+struct upload_handler: public base_handler {
+    using request_t = fhttp::request<fhttp::streaming_body>;
 
-    void handle(const fhttp::request<std::string, query_params>& request, fhttp::response<std::string>& response) {
-        
-        if (!validate_path(request.path)) {
-            response.status_code = fhttp::STATUS_CODE_FORBIDDEN;
-            return;
-        }
-
-        const auto path = config.static_files_path + request.url_matches["path"];
-        FHTTP_LOG(INFO) << "Serving file: " << path;
-
-        response.body = get_file_content(path);
-
-        if (response.body.empty()) {
-            response.status_code = fhttp::STATUS_CODE_NOT_FOUND;
-        } else {
-            response.status_code = fhttp::STATUS_CODE_OK;
-            response.headers[fhttp::HEADER_CONTENT_TYPE] = "text/html";
-        }
-    }
-
-private:
-    bool validate_path(const std::string& path) {
-        return path.find("..") == std::string::npos;
-    }
+    constexpr static const char* description = "Upload handler";
 
-    std::string get_file_content(const std::string& path) {
-        std::ifstream file(path);
-        if (!file.is_open()) {
-            return "";
-        }
+    upload_handler(const server_config& config, example_states::views_shared_state& state)
+        : base_handler(config, state) {}
 
-        std::stringstream ss;
-        ss << file.rdbuf();
-        return ss.str();
+    void handle(const request_t& request, fhttp::response<fhttp::json<example_fields::upload_response>>& response) {
+        response.headers[fhttp::HEADER_CONTENT_TYPE] = "application/json";
+        response.body->set<example_fields::status>(fhttp::STATUS_CODE_OK);
+        response.body->set<example_fields::size>(static_cast<int>(request.body.size()));
     }
 };
 
@@ -189,8 +239,11 @@ using root_router = fhttp::router<
     fhttp::route<"/echo",                   fhttp::method::post,    echo_handler>
     , fhttp::route<"/profile",              fhttp::method::post,    profile_post_handler>
     , fhttp::route<"/profile/all",          fhttp::method::post,    get_all_profiles_handler>
-    , fhttp::route<"/static/(?<path>.*)",   fhttp::method::get,     static_files_handler>
+    , fhttp::static_files_route<"/static/", &server_config::static_files_path>
     , fhttp::route<"/hello",                fhttp::method::get,     hello_handler>
+    , fhttp::route<"/upload",               fhttp::method::post,    upload_handler>
+    , fhttp::route<"/profile/export",       fhttp::method::get,     export_profiles_handler>
+    , fhttp::route<"/profile/{name}",       fhttp::method::get,     profile_get_handler>
     , fhttp::route<"/openapi.json",         fhttp::method::get,     open_api_json_handler>
 >;
 
@@ -43,6 +43,23 @@ namespace example_fields {
         using name = fhttp::datalib::field<"name", std::string, "User Name">;
     }
 
+    using size = fhttp::datalib::field<"size", int, "Number of received bytes">;
+    using upload_response = fhttp::datalib::data_pack<status, size>;
+
+    namespace path {
+        using name = fhttp::datalib::field<"name", std::string_view, "Profile Name">;
+    }
+
+    /// Parameters of "/profile/{name}"
+    using profile_path = fhttp::datalib::data_pack<path::name>;
+
+    namespace query {
+        using limit = fhttp::datalib::field<"limit", int, "Maximum number of profiles, 0 for all">;
+    }
+
+    /// Query parameters of "/profile/export"
+    using export_query = fhttp::datalib::data_pack<query::limit>;
+
     using profile_request = fhttp::datalib::data_pack<input::name>;
     using echo_request = fhttp::datalib::data_pack<echo>;
 }
\ No newline at end of file
@@ -56,8 +56,8 @@ struct fake_sql_manager {
 
 struct fake_prometheus_manager {
     void increment_request_count(
-        const std::string& path,
-        const std::string& method,
+        std::string_view path,
+        std::string_view method,
         int status_code
     ) {
         FHTTP_UNUSED(path);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "buffer_pool.h"
+
+namespace fhttp {
+
+/// @brief Monotonic arena for memory that's needed only while a request is handled and its response written
+/// (`request::arena`). Allocation is a pointer bump in a block leased from the thread's buffer_pool, nothing is
+/// freed one by one, `release()` drops everything at once and gives the block back to the pool. Whatever doesn't
+/// fit the block goes to a monotonic overflow resource that's released along with it.
+class request_arena final : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t default_block_size = 16 * 1024;
+
+    explicit request_arena(std::size_t block_size = default_block_size);
+
+    request_arena(const request_arena&) = delete;
+    request_arena& operator=(const request_arena&) = delete;
+
+    /// @brief Frees everything allocated from the arena, memory handed out before must not be used anymore
+    void release();
+
+    /// @brief Bytes allocated since the last release
+    std::size_t used() const { return used_bytes; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override { }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::size_t block_size;
+    leased_buffer block { };
+    std::size_t block_used { 0 };
+    std::size_t used_bytes { 0 };
+    std::pmr::monotonic_buffer_resource overflow { std::pmr::new_delete_resource() };
+};
+
+} // namespace fhttp
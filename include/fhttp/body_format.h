@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "header_filter.h"
+#include "headers.h"
+
+namespace fhttp {
+
+/// @brief Encodings of `json<T>` bodies, picked per request from Content-Type (request body) and Accept (response body)
+enum class body_format : std::uint8_t {
+    json,
+    msgpack,
+    cbor,
+};
+
+inline constexpr std::string_view MEDIA_TYPE_JSON = "application/json";
+inline constexpr std::string_view MEDIA_TYPE_MSGPACK = "application/msgpack";
+inline constexpr std::string_view MEDIA_TYPE_CBOR = "application/cbor";
+
+/// @brief Media types of all formats, in the order of `body_format`
+inline constexpr std::array<std::string_view, 3> body_format_media_types { MEDIA_TYPE_JSON, MEDIA_TYPE_MSGPACK, MEDIA_TYPE_CBOR };
+
+/// @brief Headers the router needs for routes with `json<T>` bodies
+inline constexpr header_filter body_format_headers = header_filter::of({ HEADER_CONTENT_TYPE, HEADER_ACCEPT });
+
+constexpr std::string_view media_type_of(body_format format) {
+    return body_format_media_types[static_cast<std::size_t>(format)];
+}
+
+/// @brief Format of a body with the given Content-Type (parameters & case are ignored, `application/x-msgpack`
+/// and `application/vnd.msgpack` are accepted as well), nothing when it's none of the supported ones
+std::optional<body_format> body_format_of(std::string_view content_type);
+
+/// @brief Adds Accept to the Vary header of a response (keeping the names set already), its body format was picked by
+/// the request's Accept so caches have to keep the formats apart
+void add_vary_accept(header_map& headers);
+
+/// @brief Format of a response preferred by the Accept header (by q-value, first listed wins a tie),
+/// JSON when the header is missing or lists none of the supported formats
+body_format accepted_body_format(std::optional<std::string_view> accept);
+
+} // namespace fhttp
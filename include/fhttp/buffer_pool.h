@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace fhttp {
+
+struct buffer_pool;
+
+/// @brief Buffer borrowed from the buffer_pool, gets returned to the pool of the thread that destroys it
+struct leased_buffer {
+    leased_buffer() = default;
+    leased_buffer(std::unique_ptr<char[]>&& data, std::size_t size);
+    leased_buffer(leased_buffer&& other) noexcept;
+    leased_buffer& operator=(leased_buffer&& other) noexcept;
+    ~leased_buffer();
+
+    char* data() const { return storage.get(); }
+    std::size_t size() const { return capacity; }
+    bool empty() const { return storage == nullptr; }
+
+    /// @brief Returns the buffer to the pool right away
+    void release();
+
+private:
+    std::unique_ptr<char[]> storage { };
+    std::size_t capacity { 0 };
+};
+
+/// @brief Per thread pool of power of two sized buffers, so connections can hold a read buffer
+/// only while they are actually reading instead of for their whole (mostly idle) lifetime
+struct buffer_pool {
+    static constexpr std::size_t min_buffer_size = 4 * 1024;
+    static constexpr std::size_t max_buffer_size = 256 * 1024;
+
+    /// @brief Maximum number of idle buffers kept per size class
+    static constexpr std::size_t max_buffers_per_class = 64;
+
+    /// @brief Pool of the calling thread
+    static buffer_pool& local();
+
+    /// @brief Leases a buffer of at least `size` bytes (clamped to [min_buffer_size, max_buffer_size])
+    leased_buffer lease(std::size_t size);
+
+private:
+    friend struct leased_buffer;
+
+    void give_back(std::unique_ptr<char[]>&& data, std::size_t size);
+
+    static std::size_t size_class(std::size_t size);
+    static constexpr std::size_t n_size_classes = 7; /* 4K, 8K, ..., 256K */
+
+    std::array<std::vector<std::unique_ptr<char[]>>, n_size_classes> free_buffers { };
+};
+
+} // namespace fhttp
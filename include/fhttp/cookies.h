@@ -1,24 +1,16 @@
 #pragma once
 
-#include <unordered_map>
-#include <string>
+#include <string_view>
 
-namespace fhttp {
-
-struct cookies {
-    cookies() = default;
+#include "key_value_view.h"
 
-    /// @brief Parses cookies from a cookie header
-    /// @param cookie_header 
-    void parse(const std::string& cookie_header);
-
-    /// @brief Retrieves a cookie by its key
-    /// @param key 
-    /// @return 
-    std::string get(const std::string& key);
+namespace fhttp {
 
-private:
-    std::unordered_map<std::string, std::string> stored_cookies;
+/// @brief Cookies of a request, a view of the raw Cookie header that's scanned on access ("a=1; b=2"),
+/// a lookup doesn't allocate and unused cookies cost nothing
+struct cookies : key_value_view {
+    constexpr cookies() = default;
+    constexpr explicit cookies(std::string_view cookie_header) : key_value_view(cookie_header, ';') { }
 };
 
 } // namespace fhttp
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <boost/json.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "fieldset.h"
+#include "json.h"
+#include "json_reader.h"
+#include "../meta.h"
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Shared parts of the MessagePack (msgpack.h) and CBOR (cbor.h) codecs */
+
+namespace fhttp {
+
+namespace datalib {
+
+namespace detail {
+
+/// @brief Appends `value` in network byte order, both formats store numbers & lengths big-endian
+template <typename number_t>
+inline void append_big_endian(std::string& out, number_t value) {
+    for (int shift = (sizeof(number_t) - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+/// @brief Reads a big-endian `value` at `position` and moves past it, false when the input is too short
+template <typename number_t>
+inline bool read_big_endian(const char*& position, const char* end, number_t& value) {
+    if (static_cast<std::size_t>(end - position) < sizeof(number_t)) {
+        return false;
+    }
+    value = 0;
+    for (std::size_t i = 0; i < sizeof(number_t); ++i) {
+        value = static_cast<number_t>((value << 8) | static_cast<unsigned char>(*position++));
+    }
+    return true;
+}
+
+} // namespace detail
+
+namespace serialization {
+
+/// @brief Writes `content` with the given encoder (msgpack_encoder, cbor_encoder): data_pack fields are walked at
+/// compile time like in write_json and their keys are pre-encoded literals (`encoder_t::key<field_t>`)
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const content_t& content);
+
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const std::vector<content_t>& content) {
+    encoder_t::write_array_header(out, content.size());
+    for (const auto& value : content) {
+        write_binary<encoder_t>(out, value);
+    }
+}
+
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const std::unordered_map<std::string, content_t>& content) {
+    encoder_t::write_map_header(out, content.size());
+    for (const auto& [key, value] : content) {
+        encoder_t::write_string(out, key);
+        write_binary<encoder_t>(out, value);
+    }
+}
+
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const std::optional<content_t>& content) {
+    if (content) {
+        write_binary<encoder_t>(out, *content);
+    } else {
+        encoder_t::write_null(out);
+    }
+}
+
+/// @brief Writes a boost::json DOM, for values that are neither data_packs nor scalars
+template <typename encoder_t>
+inline void write_binary_value(std::string& out, const boost::json::value& value) {
+    switch (value.kind()) {
+    case boost::json::kind::null: encoder_t::write_null(out); break;
+    case boost::json::kind::bool_: encoder_t::write_bool(out, value.get_bool()); break;
+    case boost::json::kind::int64: encoder_t::write_integer(out, value.get_int64()); break;
+    case boost::json::kind::uint64: encoder_t::write_unsigned(out, value.get_uint64()); break;
+    case boost::json::kind::double_: encoder_t::write_double(out, value.get_double()); break;
+    case boost::json::kind::string: encoder_t::write_string(out, std::string_view { value.get_string() }); break;
+    case boost::json::kind::array:
+        encoder_t::write_array_header(out, value.get_array().size());
+        for (const auto& element : value.get_array()) {
+            write_binary_value<encoder_t>(out, element);
+        }
+        break;
+    case boost::json::kind::object:
+        encoder_t::write_map_header(out, value.get_object().size());
+        for (const auto& entry : value.get_object()) {
+            encoder_t::write_string(out, std::string_view { entry.key() });
+            write_binary_value<encoder_t>(out, entry.value());
+        }
+        break;
+    }
+}
+
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const content_t& content) {
+    if constexpr (has_fields<content_t>::value) {
+        using fields_t = std::remove_cvref_t<decltype(content.fields)>;
+        encoder_t::write_map_header(out, std::tuple_size_v<fields_t>);
+        [&]<std::size_t... indexes>(std::index_sequence<indexes...>) {
+            ((out.append(encoder_t::template key<std::tuple_element_t<indexes, fields_t>>::view()),
+              write_binary<encoder_t>(out, std::get<indexes>(content.fields).value)), ...);
+        }(std::make_index_sequence<std::tuple_size_v<fields_t>> { });
+    } else if constexpr (std::is_same_v<content_t, bool>) {
+        encoder_t::write_bool(out, content);
+    } else if constexpr (std::is_same_v<content_t, float>) {
+        encoder_t::write_float(out, content);
+    } else if constexpr (std::is_floating_point_v<content_t>) {
+        encoder_t::write_double(out, static_cast<double>(content));
+    } else if constexpr (std::is_integral_v<content_t> and std::is_signed_v<content_t>) {
+        encoder_t::write_integer(out, static_cast<std::int64_t>(content));
+    } else if constexpr (std::is_integral_v<content_t>) {
+        encoder_t::write_unsigned(out, static_cast<std::uint64_t>(content));
+    } else if constexpr (std::is_convertible_v<const content_t&, std::string_view>) {
+        encoder_t::write_string(out, content);
+    } else {
+        if (const auto serialized = to_json(content); serialized) {
+            write_binary_value<encoder_t>(out, *serialized);
+        } else {
+            encoder_t::write_null(out);
+        }
+    }
+}
+
+namespace detail {
+
+/// @brief Pre-encoded key of a field: `header` of the string (`header_size` bytes of it) followed by the label
+template <typename field_t, auto header_of>
+struct binary_key {
+    static constexpr std::string_view label = field_t::label;
+    static constexpr auto header = header_of(label.size());
+
+    static constexpr std::array<char, header.second + label.size()> value = [] {
+        std::array<char, header.second + label.size()> result { };
+        for (std::size_t i = 0; i < header.second; ++i) {
+            result[i] = header.first[i];
+        }
+        for (std::size_t i = 0; i < label.size(); ++i) {
+            result[header.second + i] = label[i];
+        }
+        return result;
+    }();
+
+    static constexpr std::string_view view() {
+        return { value.data(), value.size() };
+    }
+};
+
+/// @brief write_binary of the fields `mask` selects, maps of data_packs are sized by the number of selected fields
+template <typename encoder_t, typename content_t>
+inline void write_binary_selected(std::string& out, const content_t& content, datalib::detail::field_mask mask) {
+    if constexpr (std::is_void_v<typename datalib::detail::nested_pack<content_t>::type>) {
+        write_binary<encoder_t>(out, content);
+    } else if constexpr (has_fields<content_t>::value) {
+        using fields_t = typename content_t::tuple_type_t;
+        using layout = datalib::detail::fieldset_layout<content_t>;
+        [&]<std::size_t... indexes>(std::index_sequence<indexes...>) {
+            encoder_t::write_map_header(out, (std::size_t { mask.test(layout::offsets[indexes]) } + ... + 0));
+            ((mask.test(layout::offsets[indexes])
+                ? (out.append(encoder_t::template key<std::tuple_element_t<indexes, fields_t>>::view()),
+                   write_binary_selected<encoder_t>(out, std::get<indexes>(content.fields).value, mask.nested(layout::offsets[indexes])))
+                : void()), ...);
+        }(std::make_index_sequence<std::tuple_size_v<fields_t>> { });
+    } else if constexpr (is_specialization<content_t, std::vector>::value) {
+        encoder_t::write_array_header(out, content.size());
+        for (const auto& value : content) {
+            write_binary_selected<encoder_t>(out, value, mask);
+        }
+    } else if (content) {
+        write_binary_selected<encoder_t>(out, *content, mask);
+    } else {
+        encoder_t::write_null(out);
+    }
+}
+
+} // namespace detail
+
+/// @brief Writes only the fields of `content` that are in `fields`
+template <typename encoder_t, typename content_t>
+inline void write_binary(std::string& out, const content_t& content, const fieldset<content_t>& fields) {
+    detail::write_binary_selected<encoder_t>(out, content, fields.mask());
+}
+
+} // namespace serialization
+
+namespace deserialization {
+
+namespace detail {
+
+/// @brief Single item of a binary encoding, arrays & maps are just their headers (number of elements/pairs)
+struct binary_token {
+    enum class kind : std::uint8_t { null, boolean, int64, uint64, float64, string, array, map };
+
+    kind type { kind::null };
+    bool boolean { false };
+    std::int64_t int64 { 0 };
+    /// Value of uint64, number of elements of an array or of pairs of a map
+    std::uint64_t uint64 { 0 };
+    double float64 { 0 };
+    std::string_view string { };
+};
+
+/// @brief Decodes the item at `position` and moves past it (past the header of a container), returns false
+/// for malformed or unsupported input
+using binary_token_decoder = bool (*)(const char*& position, const char* end, binary_token& token);
+
+/// @brief Feeds items decoded by `decoder` into a reader_handler, so binary formats are read straight into
+/// data_packs the same way JSON is. Containers are tracked on a fixed stack instead of recursion.
+boost::system::error_code read_binary(std::string_view input, json_sink root, std::pmr::memory_resource* memory, binary_token_decoder decoder);
+
+} // namespace detail
+
+} // namespace deserialization
+
+} // namespace datalib
+
+} // namespace fhttp
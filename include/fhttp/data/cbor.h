@@ -0,0 +1,77 @@
+#pragma once
+
+#include "binary.h"
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace fhttp {
+
+namespace datalib {
+
+namespace serialization {
+
+/// @brief CBOR (RFC 8949) encoding of single values, definite lengths only, integers & lengths take the
+/// smallest representation
+struct cbor_encoder {
+    static void write_null(std::string& out);
+    static void write_bool(std::string& out, bool value);
+    static void write_integer(std::string& out, std::int64_t value);
+    static void write_unsigned(std::string& out, std::uint64_t value);
+    static void write_float(std::string& out, float value);
+    static void write_double(std::string& out, double value);
+    static void write_string(std::string& out, std::string_view value);
+    static void write_array_header(std::string& out, std::size_t size);
+    static void write_map_header(std::string& out, std::size_t size);
+
+    /// @brief Header of a text string of the given size (labels are never longer than 64K)
+    static constexpr std::pair<std::array<char, 5>, std::size_t> string_header(std::size_t size) {
+        if (size < 24) {
+            return { { static_cast<char>(0x60 | size) }, 1 };
+        } else if (size < 256) {
+            return { { static_cast<char>(0x78), static_cast<char>(size) }, 2 };
+        }
+        return { { static_cast<char>(0x79), static_cast<char>(size >> 8), static_cast<char>(size & 0xff) }, 3 };
+    }
+
+    template <typename field_t>
+    using key = detail::binary_key<field_t, &string_header>;
+};
+
+/// @brief Writes `content` as CBOR into `out`, maps of data_packs are keyed by the field labels
+template <typename content_t>
+inline void write_cbor(std::string& out, const content_t& content) {
+    write_binary<cbor_encoder>(out, content);
+}
+
+template <typename content_t>
+inline void write_cbor(std::string& out, const content_t& content, const fieldset<content_t>& fields) {
+    write_binary<cbor_encoder>(out, content, fields);
+}
+
+} // namespace serialization
+
+namespace deserialization {
+
+namespace detail {
+
+bool next_cbor_token(const char*& position, const char* end, binary_token& token);
+
+} // namespace detail
+
+/// @brief Reads CBOR `input` straight into `content`, same rules as read_json (tags are skipped, indefinite
+/// lengths are not supported)
+template <typename content_t>
+boost::system::error_code read_cbor(std::string_view input, content_t& content, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::read_binary(input, detail::sink_of(content), memory, &detail::next_cbor_token);
+}
+
+} // namespace deserialization
+
+} // namespace datalib
+
+} // namespace fhttp
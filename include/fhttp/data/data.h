@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 #include <boost/json.hpp>
 
@@ -21,9 +25,11 @@ constexpr const char* type_name() {
 }
 
 template<> constexpr const char* type_name<int>() { return "integer"; }
+template<> constexpr const char* type_name<std::int64_t>() { return "integer"; }
 template<> constexpr const char* type_name<float>() { return "number"; }
 template<> constexpr const char* type_name<double>() { return "number"; }
 template<> constexpr const char* type_name<std::string>() { return "string"; }
+template<> constexpr const char* type_name<std::string_view>() { return "string"; }
 template<> constexpr const char* type_name<bool>() { return "boolean"; }
 
 namespace internal {
@@ -91,6 +97,15 @@ struct data_pack: data_pack_base {
     tuple_type_t fields;
 };
 
+/// @brief Labels of the fields of a data_pack (`field_labels<pack_t::tuple_type_t>::value`), in declaration order
+template <typename tuple_t>
+struct field_labels;
+
+template <typename... fields_t>
+struct field_labels<std::tuple<fields_t...>> {
+    static constexpr std::array<std::string_view, sizeof...(fields_t)> value { std::string_view { fields_t::label }... };
+};
+
 }; // namespace datalib
 
 }
\ No newline at end of file
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "data.h"
+#include "../meta.h"
+#include "../perfect_hash.h"
+
+/* Sparse fieldsets: which fields of a data_pack (and of the packs nested in it) get serialized */
+
+namespace fhttp {
+
+namespace datalib {
+
+namespace detail {
+
+/// @brief data_pack a value nests: the value itself, or the element of a vector or an optional, void if none
+template <typename value_t>
+struct nested_pack {
+    using type = void;
+};
+
+template <typename value_t> requires has_fields<value_t>::value
+struct nested_pack<value_t> {
+    using type = value_t;
+};
+
+template <typename element_t>
+struct nested_pack<std::vector<element_t>> : nested_pack<element_t> { };
+
+template <typename element_t>
+struct nested_pack<std::optional<element_t>> : nested_pack<element_t> { };
+
+template <typename pack_t>
+struct fieldset_layout;
+
+/* bits of a field: its own one followed by the bits of the fields of the pack it nests */
+template <typename value_t>
+constexpr std::size_t fieldset_bits() {
+    using pack_t = typename nested_pack<value_t>::type;
+    if constexpr (std::is_void_v<pack_t>) {
+        return 1;
+    } else {
+        return 1 + fieldset_layout<pack_t>::size;
+    }
+}
+
+/// @brief Selects fields by a path relative to a pack ("name", "profiles.name"), the bits of the pack start at `base`
+using fieldset_selector = bool (*)(std::string_view path, std::size_t base, std::uint64_t* words);
+
+/// @brief Bits of the fields of a data_pack in a fieldset, laid out depth first at compile time: every field has a
+/// bit and a field that nests a pack is followed by the bits of that pack's fields
+template <typename pack_t>
+struct fieldset_layout {
+    using fields_t = typename pack_t::tuple_type_t;
+
+    static constexpr auto labels = field_labels<fields_t>::value;
+    static constexpr perfect_hash<labels.size()> fields_by_label { labels };
+
+    /// Bits each field takes, including those of the pack it nests
+    static constexpr auto sizes = []<std::size_t... indexes>(std::index_sequence<indexes...>) {
+        return std::array<std::size_t, sizeof...(indexes)> {
+            fieldset_bits<typename std::tuple_element_t<indexes, fields_t>::value_type>()...
+        };
+    }(std::make_index_sequence<labels.size()> { });
+
+    /// Bit of each field, relative to the first bit of the pack
+    static constexpr auto offsets = [] {
+        std::array<std::size_t, labels.size()> result { };
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            result[i] = offset;
+            offset += sizes[i];
+        }
+        return result;
+    }();
+
+    static constexpr std::size_t size = [] {
+        std::size_t total = 0;
+        for (const auto bits : sizes) {
+            total += bits;
+        }
+        return total;
+    }();
+
+    static constexpr auto nested_selectors = []<std::size_t... indexes>(std::index_sequence<indexes...>) {
+        return std::array<fieldset_selector, sizeof...(indexes)> {
+            [] {
+                using nested_t = typename nested_pack<typename std::tuple_element_t<indexes, fields_t>::value_type>::type;
+                if constexpr (std::is_void_v<nested_t>) {
+                    return fieldset_selector { nullptr };
+                } else {
+                    return fieldset_selector { &fieldset_layout<nested_t>::select };
+                }
+            }()...
+        };
+    }(std::make_index_sequence<labels.size()> { });
+
+    /// @brief Sets the bit of the field the path names and the bits on the way to it, a path that ends at a field
+    /// nesting a pack selects all of that pack. Returns false when a label is not a field (or not a pack's field).
+    static bool select(std::string_view path, std::size_t base, std::uint64_t* words) {
+        const auto dot = path.find('.');
+        const auto index = fields_by_label.find(path.substr(0, dot));
+        if (index == fields_by_label.npos) {
+            return false;
+        }
+
+        const auto bit = base + offsets[index];
+        if (dot != std::string_view::npos) {
+            set(words, bit);
+            return nested_selectors[index] and nested_selectors[index](path.substr(dot + 1), bit + 1, words);
+        }
+        for (std::size_t i = bit; i < bit + sizes[index]; ++i) {
+            set(words, i);
+        }
+        return true;
+    }
+
+private:
+    static void set(std::uint64_t* words, std::size_t bit) {
+        words[bit / 64] |= std::uint64_t { 1 } << (bit % 64);
+    }
+};
+
+/// @brief Position in a fieldset's bits, fields of the pack being written start at `base`
+struct field_mask {
+    const std::uint64_t* words;
+    std::size_t base;
+
+    bool test(std::size_t bit) const {
+        const auto position = base + bit;
+        return (words[position / 64] >> (position % 64)) & 1;
+    }
+
+    /// @brief Mask of the pack nested in the field at `bit`
+    field_mask nested(std::size_t bit) const {
+        return { words, base + bit + 1 };
+    }
+};
+
+} // namespace detail
+
+/// @brief Fields of `content_t` (a data_pack, or a vector/optional of one) that are serialized, one bit per field
+/// of the compile-time field list, nested packs included. Built once per request from a selector like
+/// `name,profiles.name` (`?fields=` of the query), serializers then skip the fields that are not in it.
+template <typename content_t>
+class fieldset {
+public:
+    using pack_type = typename detail::nested_pack<content_t>::type;
+    static_assert(not std::is_void_v<pack_type>, "fieldset needs a data_pack (or a vector/optional of one)");
+
+    static constexpr std::size_t size = detail::fieldset_layout<pack_type>::size;
+
+    /// @brief Fieldset of comma separated dotted paths, nothing when one of them is not a field
+    /// @param unknown set to the path that's not a field
+    static std::optional<fieldset> parse(std::string_view selector, std::string_view* unknown = nullptr) {
+        fieldset result { };
+        while (not selector.empty()) {
+            const auto comma = std::min(selector.find(','), selector.size());
+            const auto path = selector.substr(0, comma);
+            selector.remove_prefix(std::min(comma + 1, selector.size()));
+
+            if (path.empty()) {
+                continue;
+            }
+            if (not detail::fieldset_layout<pack_type>::select(path, 0, result.words.data())) {
+                if (unknown) {
+                    *unknown = path;
+                }
+                return std::nullopt;
+            }
+        }
+        return result;
+    }
+
+    detail::field_mask mask() const {
+        return { words.data(), 0 };
+    }
+
+private:
+    std::array<std::uint64_t, (size + 63) / 64> words { };
+};
+
+} // namespace datalib
+
+} // namespace fhttp
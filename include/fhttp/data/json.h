@@ -2,9 +2,19 @@
 
 #include <boost/json.hpp>
 
+#include "fieldset.h"
 #include "../meta.h"
 
+#include <array>
+#include <charconv>
+#include <cmath>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace fhttp {
 
@@ -77,45 +87,296 @@ inline std::enable_if_t<has_fields<content_t>::value, std::optional<boost::json:
     return obj;
 }
 
+/* Direct serialization, values are written straight into a buffer without building a boost::json DOM */
+
+/// @brief Appends `value` as a JSON string (quoted & escaped) to `out`
+void write_json_string(std::string& out, std::string_view value);
+
+namespace detail {
+
+constexpr std::size_t json_escaped_size(char c) {
+    const auto byte = static_cast<unsigned char>(c);
+    if (c == '"' or c == '\\' or c == '\n' or c == '\r' or c == '\t' or c == '\b' or c == '\f') {
+        return 2;
+    }
+    return byte < 0x20 ? 6 : 1;
+}
+
+/// @brief `"label":` of a field (`,"label":` for all but the first one of a pack), escaped at compile time
+template <typename field_t, bool is_first>
+struct json_key {
+    static constexpr std::string_view label = field_t::label;
+
+    static constexpr std::size_t size = [] {
+        std::size_t total = (is_first ? 0 : 1) + 3;
+        for (const char c : label) {
+            total += json_escaped_size(c);
+        }
+        return total;
+    }();
+
+    static constexpr std::array<char, size> value = [] {
+        constexpr std::string_view hex = "0123456789abcdef";
+        std::array<char, size> result { };
+        std::size_t i = 0;
+        if (not is_first) {
+            result[i++] = ',';
+        }
+        result[i++] = '"';
+        for (const char c : label) {
+            const auto byte = static_cast<unsigned char>(c);
+            switch (c) {
+            case '"': result[i++] = '\\'; result[i++] = '"'; break;
+            case '\\': result[i++] = '\\'; result[i++] = '\\'; break;
+            case '\n': result[i++] = '\\'; result[i++] = 'n'; break;
+            case '\r': result[i++] = '\\'; result[i++] = 'r'; break;
+            case '\t': result[i++] = '\\'; result[i++] = 't'; break;
+            case '\b': result[i++] = '\\'; result[i++] = 'b'; break;
+            case '\f': result[i++] = '\\'; result[i++] = 'f'; break;
+            default:
+                if (byte < 0x20) {
+                    for (const char e : { '\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xf] }) {
+                        result[i++] = e;
+                    }
+                } else {
+                    result[i++] = c;
+                }
+            }
+        }
+        result[i++] = '"';
+        result[i++] = ':';
+        return result;
+    }();
+
+    static constexpr std::string_view view() {
+        return { value.data(), value.size() };
+    }
+};
+
+} // namespace detail
+
+/* Template write_json declarations, all of them before any definition so nested containers find each other */
+template <typename content_t>
+inline void write_json(std::string& out, const content_t& content);
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::vector<content_t>& content);
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::unordered_map<std::string, content_t>& content);
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::optional<content_t>& content);
+
+/* Template write_json implementations */
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::vector<content_t>& content) {
+    out.push_back('[');
+    bool is_first = true;
+    for (const auto& value : content) {
+        if (not is_first) {
+            out.push_back(',');
+        }
+        is_first = false;
+        write_json(out, value);
+    }
+    out.push_back(']');
+}
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::unordered_map<std::string, content_t>& content) {
+    out.push_back('{');
+    bool is_first = true;
+    for (const auto& [key, value] : content) {
+        if (not is_first) {
+            out.push_back(',');
+        }
+        is_first = false;
+        write_json_string(out, key);
+        out.push_back(':');
+        write_json(out, value);
+    }
+    out.push_back('}');
+}
+
+template <typename content_t>
+inline void write_json(std::string& out, const std::optional<content_t>& content) {
+    if (content) {
+        write_json(out, *content);
+    } else {
+        out.append("null");
+    }
+}
+
+/// @brief Writes `content` as compact JSON into `out` without building a boost::json DOM. data_pack fields are
+/// walked at compile time and their keys are pre-escaped literals, numbers are written by `std::to_chars` (doubles
+/// in their shortest round-trip form, `1.5` rather than boost::json's `1.5E0`, non-finite ones as `null`), strings
+/// escape `"`, `\` and control characters only. Types it doesn't know go through `to_json` and boost::json.
+template <typename content_t>
+inline void write_json(std::string& out, const content_t& content) {
+    if constexpr (has_fields<content_t>::value) {
+        out.push_back('{');
+        using fields_t = std::remove_cvref_t<decltype(content.fields)>;
+        [&]<std::size_t... indexes>(std::index_sequence<indexes...>) {
+            ((out.append(detail::json_key<std::tuple_element_t<indexes, fields_t>, indexes == 0>::view()),
+              write_json(out, std::get<indexes>(content.fields).value)), ...);
+        }(std::make_index_sequence<std::tuple_size_v<fields_t>> { });
+        out.push_back('}');
+    } else if constexpr (std::is_same_v<content_t, bool>) {
+        out.append(content ? "true" : "false");
+    } else if constexpr (std::is_floating_point_v<content_t>) {
+        if (not std::isfinite(content)) {
+            out.append("null");
+            return;
+        }
+        char digits[32];
+        const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), content);
+        out.append(digits, end);
+    } else if constexpr (std::is_arithmetic_v<content_t>) {
+        char digits[24];
+        const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), content);
+        out.append(digits, end);
+    } else if constexpr (std::is_convertible_v<const content_t&, std::string_view>) {
+        write_json_string(out, content);
+    } else {
+        if (const auto serialized = to_json(content); serialized) {
+            out.append(boost::json::serialize(*serialized));
+        }
+    }
+}
+
+namespace detail {
+
+/// @brief write_json of the fields `mask` selects, values that nest no data_pack are written as a whole
+template <typename content_t>
+inline void write_json_selected(std::string& out, const content_t& content, datalib::detail::field_mask mask) {
+    if constexpr (std::is_void_v<typename datalib::detail::nested_pack<content_t>::type>) {
+        write_json(out, content);
+    } else if constexpr (has_fields<content_t>::value) {
+        using fields_t = typename content_t::tuple_type_t;
+        using layout = datalib::detail::fieldset_layout<content_t>;
+        out.push_back('{');
+        bool is_first = true;
+        [&]<std::size_t... indexes>(std::index_sequence<indexes...>) {
+            ([&] {
+                if (not mask.test(layout::offsets[indexes])) {
+                    return;
+                }
+                if (not is_first) {
+                    out.push_back(',');
+                }
+                is_first = false;
+                out.append(json_key<std::tuple_element_t<indexes, fields_t>, true>::view());
+                write_json_selected(out, std::get<indexes>(content.fields).value, mask.nested(layout::offsets[indexes]));
+            }(), ...);
+        }(std::make_index_sequence<std::tuple_size_v<fields_t>> { });
+        out.push_back('}');
+    } else if constexpr (is_specialization<content_t, std::vector>::value) {
+        out.push_back('[');
+        bool is_first = true;
+        for (const auto& value : content) {
+            if (not is_first) {
+                out.push_back(',');
+            }
+            is_first = false;
+            write_json_selected(out, value, mask);
+        }
+        out.push_back(']');
+    } else if (content) {
+        write_json_selected(out, *content, mask);
+    } else {
+        out.append("null");
+    }
+}
+
+} // namespace detail
+
+/// @brief Writes only the fields of `content` that are in `fields`, excluded ones are skipped without being touched
+template <typename content_t>
+inline void write_json(std::string& out, const content_t& content, const fieldset<content_t>& fields) {
+    detail::write_json_selected(out, content, fields.mask());
+}
+
 } // namespace serialization
 
 namespace deserialization {
 
+/// @brief Value of `json_value` as `content_t`, nothing when it has another type or a field of a data_pack is missing
 template <typename content_t>
 inline std::optional<content_t> from_json(const boost::json::value& json_value) {
-    if constexpr (std::is_integral_v<content_t>) {
-        return { json_value.as_int64() };
+    if constexpr (std::is_same_v<content_t, bool>) {
+        if (not json_value.is_bool()) {
+            return std::nullopt;
+        }
+        return { json_value.get_bool() };
+    } else if constexpr (std::is_integral_v<content_t>) {
+        if (json_value.is_int64() and std::in_range<content_t>(json_value.get_int64())) {
+            return { static_cast<content_t>(json_value.get_int64()) };
+        }
+        if (json_value.is_uint64() and std::in_range<content_t>(json_value.get_uint64())) {
+            return { static_cast<content_t>(json_value.get_uint64()) };
+        }
+        return std::nullopt;
     } else if constexpr (std::is_floating_point_v<content_t>) {
-        return { json_value.as_double() };
+        if (json_value.is_double()) {
+            return { static_cast<content_t>(json_value.get_double()) };
+        } else if (json_value.is_int64()) {
+            return { static_cast<content_t>(json_value.get_int64()) };
+        } else if (json_value.is_uint64()) {
+            return { static_cast<content_t>(json_value.get_uint64()) };
+        }
+        return std::nullopt;
     } else if constexpr (std::is_same_v<content_t, std::string>) {
-        return std::make_optional<std::string>(json_value.as_string());
-    } else if constexpr (std::is_same_v<content_t, bool>) {
-        return { json_value.as_bool() };
+        if (not json_value.is_string()) {
+            return std::nullopt;
+        }
+        return std::make_optional<std::string>(json_value.get_string());
     } else if constexpr (is_specialization<content_t, std::vector>::value) {
-        content_t out_vector { };
-        const auto& json_array = json_value.as_array();
+        const auto* json_array = json_value.if_array();
+        if (not json_array) {
+            return std::nullopt;
+        }
 
-        for (const auto& elem : json_array) {
-            if (const auto deserialized = from_json<typename content_t::value_type>(elem); deserialized) {
-                out_vector.push_back(*deserialized);
+        content_t out_vector { };
+        for (const auto& elem : *json_array) {
+            auto deserialized = from_json<typename content_t::value_type>(elem);
+            if (not deserialized) {
+                return std::nullopt;
             }
+            out_vector.push_back(std::move(*deserialized));
         }
 
+        return std::make_optional(std::move(out_vector));
     } else {
-        content_t data_pack_content;
+        const auto* json_object = json_value.if_object();
+        if (not json_object) {
+            return std::nullopt;
+        }
 
-        std::apply([&](auto&& ... args) {
-            ([&] {
+        content_t data_pack_content;
+        const bool complete = std::apply([&](auto&& ... args) {
+            return ([&] {
                 using field_t = std::decay_t<decltype(args)>;
                 using field_value_t = typename field_t::value_type;
 
-                if (const auto deserialized = from_json<field_value_t>(json_value.as_object().at(args.label)); deserialized) {
-                    data_pack_content.template set<field_t>({ *deserialized });
+                const auto* field_value = json_object->if_contains(args.label);
+                if (not field_value) {
+                    return false;
                 }
-            } (), ...);
+                auto deserialized = from_json<field_value_t>(*field_value);
+                if (not deserialized) {
+                    return false;
+                }
+                args.value = std::move(*deserialized);
+                return true;
+            } () and ...);
         }, data_pack_content.fields);
 
-        return std::make_optional(data_pack_content);
+        if (not complete) {
+            return std::nullopt;
+        }
+        return std::make_optional(std::move(data_pack_content));
     }
 }
 
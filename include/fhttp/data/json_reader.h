@@ -0,0 +1,386 @@
+#pragma once
+
+#include <boost/json/basic_parser_impl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "data.h"
+#include "../meta.h"
+#include "../perfect_hash.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fhttp {
+
+namespace datalib {
+
+namespace deserialization {
+
+/// @brief Errors of `read_json` besides the syntax errors reported by boost::json
+enum class json_read_error {
+    type_mismatch = 1,
+    missing_field,
+    too_deep,
+    invalid_encoding,
+};
+
+const boost::system::error_category& json_read_category();
+
+inline boost::system::error_code make_error_code(json_read_error error) {
+    return { static_cast<int>(error), json_read_category() };
+}
+
+namespace detail {
+
+struct json_sink;
+
+/// @brief Events one destination type accepts, value events return false if the JSON value has another type
+struct json_sink_vtable {
+    bool (*on_bool)(void* target, bool value);
+    bool (*on_int64)(void* target, std::int64_t value);
+    bool (*on_uint64)(void* target, std::uint64_t value);
+    bool (*on_double)(void* target, double value);
+    bool (*on_string)(void* target, std::string_view value);
+    /* objects: destination of the value of `key`, false for a key that is not a field */
+    bool (*on_key)(void* target, std::string_view key, json_sink& value, std::uint64_t& seen);
+    /* objects: whether every field was present */
+    bool (*is_complete)(std::uint64_t seen);
+    /* arrays: destination of a new element */
+    void (*on_element)(void* target, json_sink& element);
+    bool is_object;
+    bool is_array;
+};
+
+/// @brief Type-erased destination of a single JSON value
+struct json_sink {
+    void* target { nullptr };
+    const json_sink_vtable* vtable { nullptr };
+};
+
+template <typename value_t>
+json_sink sink_of(value_t& value);
+
+template <typename value_t>
+struct value_reader {
+    static bool on_bool(void* target, bool value) {
+        if constexpr (std::is_same_v<value_t, bool>) {
+            *static_cast<value_t*>(target) = value;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename number_t>
+    static bool on_integer(void* target, number_t value) {
+        if constexpr (std::is_integral_v<value_t> and not std::is_same_v<value_t, bool>) {
+            if (not std::in_range<value_t>(value)) {
+                return false;
+            }
+            *static_cast<value_t*>(target) = static_cast<value_t>(value);
+            return true;
+        } else if constexpr (std::is_floating_point_v<value_t>) {
+            *static_cast<value_t*>(target) = static_cast<value_t>(value);
+            return true;
+        }
+        return false;
+    }
+
+    static bool on_int64(void* target, std::int64_t value) { return on_integer(target, value); }
+    static bool on_uint64(void* target, std::uint64_t value) { return on_integer(target, value); }
+
+    static bool on_double(void* target, double value) {
+        if constexpr (std::is_floating_point_v<value_t>) {
+            *static_cast<value_t*>(target) = static_cast<value_t>(value);
+            return true;
+        }
+        return false;
+    }
+
+    static bool on_string(void* target, std::string_view value) {
+        /* std::string_view fields can't be read, unescaped strings don't outlive the parser */
+        if constexpr (std::is_same_v<value_t, std::string>) {
+            static_cast<value_t*>(target)->assign(value);
+            return true;
+        }
+        return false;
+    }
+
+    static bool on_key(void*, std::string_view, json_sink&, std::uint64_t&) { return false; }
+    static bool is_complete(std::uint64_t) { return true; }
+    static void on_element(void*, json_sink&) { }
+
+    static constexpr json_sink_vtable vtable {
+        on_bool, on_int64, on_uint64, on_double, on_string, on_key, is_complete, on_element, false, false,
+    };
+};
+
+template <typename element_t>
+struct value_reader<std::vector<element_t>> : value_reader<void> {
+    static void on_element(void* target, json_sink& element) {
+        auto& elements = *static_cast<std::vector<element_t>*>(target);
+        element = sink_of(elements.emplace_back());
+    }
+
+    static constexpr json_sink_vtable vtable {
+        value_reader<void>::on_bool, value_reader<void>::on_int64, value_reader<void>::on_uint64,
+        value_reader<void>::on_double, value_reader<void>::on_string, value_reader<void>::on_key,
+        value_reader<void>::is_complete, on_element, false, true,
+    };
+};
+
+/// @brief Keys of a data_pack are dispatched to its fields through a perfect hash of the labels
+template <typename pack_t> requires has_fields<pack_t>::value
+struct value_reader<pack_t> : value_reader<void> {
+    using fields_t = typename pack_t::tuple_type_t;
+
+    static constexpr auto labels = field_labels<fields_t>::value;
+    static constexpr perfect_hash<labels.size()> fields_by_label { labels };
+
+    static_assert(labels.size() <= 64, "data_pack with more than 64 fields can't be read from JSON");
+
+    static constexpr std::uint64_t all_fields = labels.size() == 64
+        ? ~std::uint64_t { 0 } : (std::uint64_t { 1 } << labels.size()) - 1;
+
+    static constexpr auto field_sinks = []<std::size_t... indexes>(std::index_sequence<indexes...>) {
+        return std::array<json_sink (*)(pack_t&), sizeof...(indexes)> {
+            +[](pack_t& pack) { return sink_of(std::get<indexes>(pack.fields).value); }...
+        };
+    }(std::make_index_sequence<labels.size()> { });
+
+    static bool on_key(void* target, std::string_view key, json_sink& value, std::uint64_t& seen) {
+        const auto index = fields_by_label.find(key);
+        if (index == fields_by_label.npos) {
+            return false;
+        }
+        seen |= std::uint64_t { 1 } << index;
+        value = field_sinks[index](*static_cast<pack_t*>(target));
+        return true;
+    }
+
+    static bool is_complete(std::uint64_t seen) {
+        return seen == all_fields;
+    }
+
+    static constexpr json_sink_vtable vtable {
+        value_reader<void>::on_bool, value_reader<void>::on_int64, value_reader<void>::on_uint64,
+        value_reader<void>::on_double, value_reader<void>::on_string, on_key,
+        is_complete, value_reader<void>::on_element, true, false,
+    };
+};
+
+template <typename value_t>
+json_sink sink_of(value_t& value) {
+    return { &value, &value_reader<value_t>::vtable };
+}
+
+/// @brief boost::json::basic_parser handler that writes values straight into their destination, values of unknown
+/// keys are skipped (only their nesting depth is tracked). MessagePack & CBOR decoders emit the same events (binary.h).
+/// Nothing is allocated unless a key or a string arrives in parts, then the parts are joined in `part` (allocated
+/// from the given memory resource).
+class reader_handler {
+public:
+    static constexpr std::size_t max_object_size = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t max_array_size = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t max_key_size = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t max_string_size = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t max_depth = 32;
+
+    reader_handler(json_sink root, std::pmr::memory_resource* memory)
+        : root(root)
+        , part(memory)
+    {}
+
+    bool on_document_begin(boost::system::error_code&) { return true; }
+    bool on_document_end(boost::system::error_code&) { return true; }
+
+    bool on_object_begin(boost::system::error_code& ec) { return begin_container(ec, false); }
+    bool on_array_begin(boost::system::error_code& ec) { return begin_container(ec, true); }
+
+    bool on_object_end(std::size_t, boost::system::error_code& ec) {
+        if (skip_depth > 0) {
+            --skip_depth;
+            return true;
+        }
+        const auto& top = stack[--depth];
+        if (not top.sink.vtable->is_complete(top.seen)) {
+            ec = make_error_code(json_read_error::missing_field);
+            return false;
+        }
+        return true;
+    }
+
+    bool on_array_end(std::size_t, boost::system::error_code&) {
+        if (skip_depth > 0) {
+            --skip_depth;
+        } else {
+            --depth;
+        }
+        return true;
+    }
+
+    bool on_key_part(boost::json::string_view key, std::size_t, boost::system::error_code&) {
+        if (skip_depth == 0) {
+            part.append(key.data(), key.size());
+        }
+        return true;
+    }
+
+    bool on_key(boost::json::string_view key, std::size_t, boost::system::error_code&) {
+        if (skip_depth > 0) {
+            return true;
+        }
+        auto& top = stack[depth - 1];
+        std::string_view name { key.data(), key.size() };
+        if (not part.empty()) {
+            part.append(name);
+            name = part;
+        }
+        skip_next = not top.sink.vtable->on_key(top.sink.target, name, pending, top.seen);
+        part.clear();
+        return true;
+    }
+
+    bool on_string_part(boost::json::string_view value, std::size_t, boost::system::error_code&) {
+        if (skip_depth == 0 and not skip_next) {
+            part.append(value.data(), value.size());
+        }
+        return true;
+    }
+
+    bool on_string(boost::json::string_view value, std::size_t, boost::system::error_code& ec) {
+        std::string_view text { value.data(), value.size() };
+        if (not part.empty()) {
+            part.append(text);
+            text = part;
+        }
+        const bool ok = on_value(ec, [&](const json_sink& sink) { return sink.vtable->on_string(sink.target, text); });
+        part.clear();
+        return ok;
+    }
+
+    bool on_number_part(boost::json::string_view, boost::system::error_code&) { return true; }
+
+    bool on_int64(std::int64_t value, boost::json::string_view, boost::system::error_code& ec) {
+        return on_value(ec, [&](const json_sink& sink) { return sink.vtable->on_int64(sink.target, value); });
+    }
+
+    bool on_uint64(std::uint64_t value, boost::json::string_view, boost::system::error_code& ec) {
+        return on_value(ec, [&](const json_sink& sink) { return sink.vtable->on_uint64(sink.target, value); });
+    }
+
+    bool on_double(double value, boost::json::string_view, boost::system::error_code& ec) {
+        return on_value(ec, [&](const json_sink& sink) { return sink.vtable->on_double(sink.target, value); });
+    }
+
+    bool on_bool(bool value, boost::system::error_code& ec) {
+        return on_value(ec, [&](const json_sink& sink) { return sink.vtable->on_bool(sink.target, value); });
+    }
+
+    /* null keeps the default value */
+    bool on_null(boost::system::error_code& ec) {
+        return on_value(ec, [](const json_sink&) { return true; });
+    }
+
+    bool on_comment_part(boost::json::string_view, boost::system::error_code&) { return true; }
+    bool on_comment(boost::json::string_view, boost::system::error_code&) { return true; }
+
+private:
+    struct frame {
+        json_sink sink { };
+        std::uint64_t seen { 0 };
+    };
+
+    /* whether the value that starts now is skipped (it's inside, or it is, a value of an unknown key) */
+    bool skips_value() {
+        if (skip_depth > 0) {
+            return true;
+        }
+        if (skip_next) {
+            skip_next = false;
+            return true;
+        }
+        return false;
+    }
+
+    /* destination of the value that starts now */
+    json_sink take_sink() {
+        if (depth == 0) {
+            return root;
+        }
+        auto& top = stack[depth - 1];
+        if (top.sink.vtable->is_array) {
+            top.sink.vtable->on_element(top.sink.target, pending);
+        }
+        return pending;
+    }
+
+    template <typename write_t>
+    bool on_value(boost::system::error_code& ec, write_t&& write) {
+        if (skips_value()) {
+            return true;
+        }
+        if (not write(take_sink())) {
+            ec = make_error_code(json_read_error::type_mismatch);
+            return false;
+        }
+        return true;
+    }
+
+    bool begin_container(boost::system::error_code& ec, bool is_array) {
+        if (skips_value()) {
+            ++skip_depth;
+            return true;
+        }
+        const auto sink = take_sink();
+        if (is_array ? not sink.vtable->is_array : not sink.vtable->is_object) {
+            ec = make_error_code(json_read_error::type_mismatch);
+            return false;
+        }
+        if (depth == max_depth) {
+            ec = make_error_code(json_read_error::too_deep);
+            return false;
+        }
+        stack[depth++] = { sink, 0 };
+        return true;
+    }
+
+    json_sink root;
+    json_sink pending { };
+    std::array<frame, max_depth> stack { };
+    std::size_t depth { 0 };
+    std::size_t skip_depth { 0 };
+    bool skip_next { false };
+    std::pmr::string part;
+};
+
+} // namespace detail
+
+/// @brief Reads JSON `input` straight into `content` (data_pack, vector or a scalar) without building a DOM.
+/// Every field of a data_pack has to be present (null keeps the default), keys that are not fields are skipped.
+/// @param memory scratch memory for keys & strings split into parts, e.g. the request's arena
+template <typename content_t>
+boost::system::error_code read_json(std::string_view input, content_t& content, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    boost::json::basic_parser<detail::reader_handler> parser { boost::json::parse_options { }, detail::sink_of(content), memory };
+    boost::system::error_code ec;
+    const auto consumed = parser.write_some(false, input.data(), input.size(), ec);
+    if (not ec and consumed != input.size()) {
+        ec = boost::json::error::extra_data;
+    }
+    return ec;
+}
+
+} // namespace deserialization
+
+} // namespace datalib
+
+} // namespace fhttp
+
+template <>
+struct boost::system::is_error_code_enum<fhttp::datalib::deserialization::json_read_error> : std::true_type {};
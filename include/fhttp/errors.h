@@ -1,10 +1,43 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include "response.h"
 
 namespace fhttp {
 
-/// @brief Errors that are gonna be catched by the runtime and returned to the client
-/// TODO:
+/// @brief Errors that are answered by the runtime, the request doesn't reach (or is taken from) its handler.
+/// Nothing on the decoding path throws, every step reports one of these instead.
+enum class request_error : std::uint8_t {
+    /// Request line or headers can't be parsed, or they frame the body ambiguously (400)
+    malformed_request,
+    /// Content-Length is not a number, or there are several different ones (400)
+    invalid_content_length,
+    /// Body or a chunk of it is bigger than the configured limit (413)
+    payload_too_large,
+    /// Method the server doesn't know (501)
+    method_not_implemented,
+    /// Transfer-Encoding other than just `chunked`, e.g. `gzip, chunked` (501)
+    transfer_coding_not_implemented,
+    /// Body can't be decoded into the handler's body type (400)
+    invalid_body,
+    /// Query parameter can't be converted into its field (400)
+    invalid_query_parameter,
+    /// Integer path parameter doesn't fit its field (400)
+    invalid_path_parameter,
+    /// Handler failed (500)
+    internal_error,
+};
+
+/// @brief Status code the error is answered with
+int status_code_of(request_error error);
+
+/// @brief Stable name of the error for clients, e.g. "invalid_body"
+std::string_view name_of(request_error error);
+
+/// @brief Sets status and a JSON body `{"status":400,"error":"invalid_body","message":"..."}` of the response
+void set_error_response(response<std::string>& resp, request_error error, std::string_view message = { });
 
-} // namespace fhttp
\ No newline at end of file
+} // namespace fhttp
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fhttp {
+
+/// @brief Opened file together with its stat data, file descriptor is closed once nothing references it
+struct cached_file {
+    cached_file(int fd, std::size_t size, std::time_t modified_at, std::uint64_t inode, std::string content_type);
+    ~cached_file();
+
+    cached_file(const cached_file&) = delete;
+    cached_file& operator=(const cached_file&) = delete;
+
+    int fd;
+    std::size_t size;
+    std::time_t modified_at;
+    std::uint64_t inode;
+    std::string content_type;
+
+    /* validators, used for If-Range */
+    std::string etag;
+    std::string last_modified;
+
+    /* when the file was last checked against the filesystem */
+    std::chrono::steady_clock::time_point checked_at;
+};
+
+/// @brief Part of a file that's sent as a response body straight from the page cache (sendfile)
+struct file_region {
+    std::shared_ptr<const cached_file> file { };
+    std::size_t offset { 0 };
+    std::size_t length { 0 };
+
+    explicit operator bool() const {
+        return file != nullptr;
+    }
+};
+
+/// @brief Response body made of file regions, each one optionally preceded by some in-memory bytes
+/// (e.g. multipart/byteranges part headers), a trailing in-memory part can have an empty region
+struct file_body {
+    struct part {
+        std::string prefix { };
+        file_region region { };
+    };
+
+    file_body() = default;
+    file_body(file_region region) {
+        parts.push_back({ { }, std::move(region) });
+    }
+
+    /// @brief Total number of bytes of the body
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& part : parts) {
+            total += part.prefix.size() + part.region.length;
+        }
+        return total;
+    }
+
+    explicit operator bool() const {
+        return not parts.empty();
+    }
+
+    std::vector<part> parts { };
+};
+
+/// @brief Cache of opened files, so serving a file doesn't need open + fstat on every request.
+/// Entries are revalidated (stat) at most once per `revalidate_interval`.
+struct file_cache {
+    static constexpr std::chrono::seconds revalidate_interval { 1 };
+    static constexpr std::size_t max_entries = 4096;
+
+    /// @brief Returns opened file, nullptr if it doesn't exist or is not a regular file
+    std::shared_ptr<const cached_file> get(const std::string& path);
+
+private:
+    std::shared_ptr<const cached_file> open(const std::string& path);
+
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<cached_file>> files;
+};
+
+/// @brief Content-Type based on the file extension
+std::string_view mime_type(std::string_view path);
+
+/// @brief Formats time as an HTTP-date (RFC 9110), e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string http_date(std::time_t time);
+
+} // namespace fhttp
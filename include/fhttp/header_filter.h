@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+#include "header_map.h"
+
+namespace fhttp {
+
+/// @brief Set of request header names that are worth storing, built at compile time from what the router's
+/// handlers declare (`request_headers`), all other headers are skipped by the parser without being stored
+struct header_filter {
+    static constexpr std::size_t max_custom_headers = 32;
+
+    /// @brief Filter that keeps every header, used for handlers which don't declare what they read
+    static constexpr header_filter all() {
+        return header_filter { };
+    }
+
+    /// @brief Filter that keeps only the given headers
+    static constexpr header_filter of(std::initializer_list<std::string_view> names) {
+        return of_range(names);
+    }
+
+    template <typename range_t>
+    static constexpr header_filter of_range(const range_t& names) {
+        header_filter filter { };
+        filter.retain_all = false;
+        for (const std::string_view name : names) {
+            filter.add(name);
+        }
+        return filter;
+    }
+
+    /// @brief Union of both filters
+    constexpr header_filter merged(const header_filter& other) const {
+        header_filter filter = *this;
+        filter.retain_all = retain_all or other.retain_all;
+        filter.known |= other.known;
+        for (std::size_t i = 0; i < other.custom_count; ++i) {
+            filter.add(other.custom[i]);
+        }
+        return filter;
+    }
+
+    constexpr bool retains(std::string_view name) const {
+        if (retain_all) {
+            return true;
+        }
+
+        if (const auto header = find_known_header(name)) {
+            return retains(*header);
+        }
+
+        for (std::size_t i = 0; i < custom_count; ++i) {
+            if (header_name_equals(custom[i], name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr bool retains(known_header header) const {
+        return retain_all or (known & bit(header)) != 0;
+    }
+
+    bool retain_all { true };
+    std::uint64_t known { 0 };
+    std::array<std::string_view, max_custom_headers> custom { };
+    std::size_t custom_count { 0 };
+
+private:
+    static constexpr std::uint64_t bit(known_header header) {
+        return std::uint64_t { 1 } << static_cast<std::size_t>(header);
+    }
+
+    constexpr void add(std::string_view name) {
+        if (const auto header = find_known_header(name)) {
+            known |= bit(*header);
+            return;
+        }
+
+        for (std::size_t i = 0; i < custom_count; ++i) {
+            if (header_name_equals(custom[i], name)) {
+                return;
+            }
+        }
+
+        if (custom_count == max_custom_headers) {
+            throw "too many custom request headers declared";
+        }
+        custom[custom_count++] = name;
+    }
+};
+
+static_assert(known_header_count <= 64);
+
+/// @brief Headers the server itself needs regardless of handlers (body framing & keep-alive)
+inline constexpr header_filter framework_headers = header_filter::of({
+    HEADER_CONTENT_LENGTH,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_CONNECTION,
+});
+
+/// @brief Headers a handler reads, declared as e.g.
+/// `static constexpr std::array<std::string_view, 1> request_headers { fhttp::HEADER_AUTHORIZATION };`,
+/// handler without the declaration gets all headers
+template <typename handler_t>
+constexpr header_filter request_headers_of() {
+    if constexpr (requires { handler_t::request_headers; }) {
+        return header_filter::of_range(handler_t::request_headers);
+    } else {
+        return header_filter::all();
+    }
+}
+
+} // namespace fhttp
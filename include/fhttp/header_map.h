@@ -0,0 +1,431 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <boost/container/small_vector.hpp>
+
+#include "headers.h"
+
+namespace fhttp {
+
+/// @brief Well known headers (from headers.h), recognized once when a header is added and then accessible
+/// through a fixed slot, without hashing or comparing the name again
+enum class known_header : std::uint8_t {
+    content_length,
+    transfer_encoding,
+    connection,
+    host,
+    cookie,
+    content_type,
+    user_agent,
+    accept,
+    accept_encoding,
+    accept_language,
+    accept_charset,
+    authorization,
+    cache_control,
+    origin,
+    referer,
+    range,
+    if_range,
+    if_none_match,
+    if_modified_since,
+    expect,
+    location,
+    set_cookie,
+    server,
+    date,
+    etag,
+    last_modified,
+    content_range,
+    accept_ranges,
+};
+
+inline constexpr std::array<std::string_view, 28> known_header_names {
+    HEADER_CONTENT_LENGTH,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_CONNECTION,
+    HEADER_HOST,
+    HEADER_COOKIE,
+    HEADER_CONTENT_TYPE,
+    HEADER_USER_AGENT,
+    HEADER_ACCEPT,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_ACCEPT_LANGUAGE,
+    HEADER_ACCEPT_CHARSET,
+    HEADER_AUTHORIZATION,
+    HEADER_CACHE_CONTROL,
+    HEADER_ORIGIN,
+    HEADER_REFERER,
+    HEADER_RANGE,
+    HEADER_IF_RANGE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_EXPECT,
+    HEADER_LOCATION,
+    HEADER_SET_COOKIE,
+    HEADER_SERVER,
+    HEADER_DATE,
+    HEADER_ETAG,
+    HEADER_LAST_MODIFIED,
+    HEADER_CONTENT_RANGE,
+    HEADER_ACCEPT_RANGES,
+};
+
+inline constexpr std::size_t known_header_count = known_header_names.size();
+
+static_assert(static_cast<std::size_t>(known_header::accept_ranges) + 1 == known_header_count);
+
+namespace detail {
+
+constexpr char to_lower_ascii(char c) {
+    return c >= 'A' and c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/* case-insensitive FNV-1a */
+constexpr std::uint32_t header_name_hash(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = 2166136261u ^ seed;
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(to_lower_ascii(c));
+        hash *= 16777619u;
+    }
+
+    /* low bits pick the bucket, so mix the high bits (where the seed matters) into them */
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+struct known_header_table {
+    static constexpr std::size_t size = 128;
+
+    std::uint32_t seed { 0 };
+    /* known_header + 1, 0 for an empty bucket */
+    std::array<std::uint8_t, size> buckets { };
+};
+
+/* Searches for a seed with which no two known headers share a bucket, so a lookup is a single hash & compare */
+constexpr known_header_table make_known_header_table() {
+    for (std::uint32_t seed = 0; seed < 1'000'000; ++seed) {
+        known_header_table table { seed, { } };
+
+        bool is_perfect = true;
+        for (std::size_t i = 0; i < known_header_count and is_perfect; ++i) {
+            auto& bucket = table.buckets[header_name_hash(known_header_names[i], seed) % known_header_table::size];
+            is_perfect = bucket == 0;
+            bucket = static_cast<std::uint8_t>(i + 1);
+        }
+
+        if (is_perfect) {
+            return table;
+        }
+    }
+
+    throw "no perfect hash seed for known headers";
+}
+
+inline constexpr known_header_table known_headers_table = make_known_header_table();
+
+} // namespace detail
+
+/// @brief Compares header names, which are case-insensitive
+constexpr bool header_name_equals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (detail::to_lower_ascii(a[i]) != detail::to_lower_ascii(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Recognizes a well known header name (case-insensitive) using a compile-time perfect hash
+constexpr std::optional<known_header> find_known_header(std::string_view name) {
+    const auto& table = detail::known_headers_table;
+    const auto bucket = table.buckets[detail::header_name_hash(name, table.seed) % detail::known_header_table::size];
+
+    if (bucket == 0 or not header_name_equals(known_header_names[bucket - 1], name)) {
+        return std::nullopt;
+    }
+    return static_cast<known_header>(bucket - 1);
+}
+
+/// @brief Flat header container with case-insensitive names, headers are kept inline in insertion order
+/// (several headers with the same name are allowed, lookups return the first one). Well known headers get
+/// a fixed slot, Content-Length & Connection are parsed as soon as they are complete.
+/// @tparam string_t std::string for owned headers, std::string_view for views of the read buffer
+template <typename string_t>
+struct basic_header_map {
+    using value_type = std::pair<string_t, string_t>;
+
+    static constexpr std::size_t inline_capacity = 16;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    using container_type = boost::container::small_vector<value_type, inline_capacity>;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    std::size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void clear() {
+        entries.clear();
+        known_ids.clear();
+        slots.fill(0);
+        content_length_ = std::nullopt;
+        keep_alive_ = std::nullopt;
+        is_parsed_stale = false;
+    }
+
+    /// @brief Index of the first header with the given name, npos if there's none
+    std::size_t index_of(std::string_view name) const {
+        if (const auto known = find_known_header(name)) {
+            return index_of(*known);
+        }
+
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (header_name_equals(entries[i].first, name)) {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    std::size_t index_of(known_header header) const {
+        return static_cast<std::size_t>(slots[static_cast<std::size_t>(header)]) - 1;
+    }
+
+    template <typename name_t>
+    iterator find(const name_t& name) {
+        const auto index = index_of(name);
+        return index == npos ? entries.end() : entries.begin() + static_cast<std::ptrdiff_t>(index);
+    }
+
+    template <typename name_t>
+    const_iterator find(const name_t& name) const {
+        const auto index = index_of(name);
+        return index == npos ? entries.end() : entries.begin() + static_cast<std::ptrdiff_t>(index);
+    }
+
+    template <typename name_t>
+    bool contains(const name_t& name) const {
+        return index_of(name) != npos;
+    }
+
+    /// @brief Number of headers with the given name
+    std::size_t count(std::string_view name) const {
+        if (const auto known = find_known_header(name)) {
+            return count(*known);
+        }
+
+        std::size_t total = 0;
+        for (const auto& [entry_name, value] : entries) {
+            total += header_name_equals(entry_name, name) ? 1 : 0;
+        }
+        return total;
+    }
+
+    std::size_t count(known_header header) const {
+        if (slots[static_cast<std::size_t>(header)] == 0) {
+            return 0;
+        }
+
+        std::size_t total = 0;
+        for (const auto id : known_ids) {
+            total += id == static_cast<std::uint8_t>(header) ? 1 : 0;
+        }
+        return total;
+    }
+
+    /// @brief Value of the first header with the given name
+    template <typename name_t>
+    std::optional<std::string_view> get(const name_t& name) const {
+        const auto index = index_of(name);
+        if (index == npos) {
+            return std::nullopt;
+        }
+        return std::string_view { entries[index].second };
+    }
+
+    template <typename name_t>
+    const string_t& at(const name_t& name) const {
+        const auto index = index_of(name);
+        if (index == npos) {
+            throw std::out_of_range { "header not found" };
+        }
+        return entries[index].second;
+    }
+
+    /// @brief Value of the first header with the given name, header with an empty value is added if there's none
+    string_t& operator[](std::string_view name) {
+        auto index = index_of(name);
+        if (index == npos) {
+            index = insert(string_t { name }, string_t { });
+        }
+
+        /* value may be changed through the reference, parse it again once it's asked for */
+        if (is_parsed(known_ids[index])) {
+            is_parsed_stale = true;
+        }
+        return entries[index].second;
+    }
+
+    /// @brief Adds a header even if there already is one with the same name (e.g. Set-Cookie), returns its index
+    std::size_t append(string_t name, string_t value) {
+        const auto index = insert(std::move(name), std::move(value));
+        parse_value(index);
+        return index;
+    }
+
+    /// @brief Adds a header with an empty value, used by the parser that fills the value in pieces with
+    /// value_at() and then calls complete()
+    std::size_t start(string_t name) {
+        return insert(std::move(name), string_t { });
+    }
+
+    /// @brief Value of the header at `index`, used by the parser to fill the value in pieces
+    string_t& value_at(std::size_t index) {
+        return entries[index].second;
+    }
+
+    /// @brief Called once the value of the header at `index` is complete, parses it if it's one of the pre-parsed headers
+    void complete(std::size_t index) {
+        parse_value(index);
+    }
+
+    /// @brief Map of views of another map's headers, recognized known headers & parsed values are taken over
+    /// as they are, so nothing is hashed or parsed again
+    template <typename other_string_t>
+    static basic_header_map view_of(const basic_header_map<other_string_t>& other) requires std::is_same_v<string_t, std::string_view> {
+        basic_header_map view { };
+        for (const auto& [name, value] : other.entries) {
+            view.entries.emplace_back(name, value);
+        }
+        view.known_ids.assign(other.known_ids.begin(), other.known_ids.end());
+        view.slots = other.slots;
+        other.refresh_parsed();
+        view.content_length_ = other.content_length_;
+        view.keep_alive_ = other.keep_alive_;
+        return view;
+    }
+
+    /// @brief Parsed Content-Length, empty when there's none or it's invalid (not a number, conflicting duplicates)
+    std::optional<std::size_t> content_length() const {
+        refresh_parsed();
+        return content_length_;
+    }
+
+    /// @brief false for `Connection: close`, true for `Connection: keep-alive`, empty without a Connection header
+    std::optional<bool> keep_alive() const {
+        refresh_parsed();
+        return keep_alive_;
+    }
+
+private:
+    template <typename>
+    friend struct basic_header_map;
+
+    static constexpr std::uint8_t unknown_id = 0xff;
+
+    std::size_t insert(string_t name, string_t value) {
+        const auto known = find_known_header(name);
+        const auto index = entries.size();
+
+        entries.emplace_back(std::move(name), std::move(value));
+        known_ids.push_back(known ? static_cast<std::uint8_t>(*known) : unknown_id);
+
+        if (known and slots[static_cast<std::size_t>(*known)] == 0) {
+            slots[static_cast<std::size_t>(*known)] = static_cast<std::uint16_t>(index + 1);
+        }
+        return index;
+    }
+
+    static bool is_parsed(std::uint8_t id) {
+        return id == static_cast<std::uint8_t>(known_header::content_length) or id == static_cast<std::uint8_t>(known_header::connection);
+    }
+
+    void parse_value(std::size_t index) const {
+        const std::string_view value = entries[index].second;
+
+        if (known_ids[index] == static_cast<std::uint8_t>(known_header::content_length)) {
+            std::optional<std::size_t> parsed { };
+            std::size_t length = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+            if (ec == std::errc { } and end == value.data() + value.size() and not value.empty()) {
+                parsed = length;
+            }
+
+            /* duplicates have to agree, otherwise the length is ambiguous */
+            if (index == index_of(known_header::content_length)) {
+                content_length_ = parsed;
+            } else if (content_length_ != parsed) {
+                content_length_ = std::nullopt;
+            }
+        } else if (known_ids[index] == static_cast<std::uint8_t>(known_header::connection)) {
+            std::string_view options = value;
+            while (not options.empty()) {
+                const auto comma = options.find(',');
+                auto option = options.substr(0, comma);
+                options = comma == std::string_view::npos ? std::string_view { } : options.substr(comma + 1);
+
+                while (not option.empty() and (option.front() == ' ' or option.front() == '\t')) {
+                    option.remove_prefix(1);
+                }
+                while (not option.empty() and (option.back() == ' ' or option.back() == '\t')) {
+                    option.remove_suffix(1);
+                }
+
+                if (header_name_equals(option, "close")) {
+                    keep_alive_ = false;
+                } else if (header_name_equals(option, "keep-alive") and keep_alive_ != false) {
+                    keep_alive_ = true;
+                }
+            }
+        }
+    }
+
+    void refresh_parsed() const {
+        if (not is_parsed_stale) {
+            return;
+        }
+
+        is_parsed_stale = false;
+        content_length_ = std::nullopt;
+        keep_alive_ = std::nullopt;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (is_parsed(known_ids[i])) {
+                parse_value(i);
+            }
+        }
+    }
+
+    container_type entries { };
+    boost::container::small_vector<std::uint8_t, inline_capacity> known_ids { };
+    /* index + 1 of the first header of each known name, 0 when there's none */
+    std::array<std::uint16_t, known_header_count> slots { };
+
+    mutable std::optional<std::size_t> content_length_ { };
+    mutable std::optional<bool> keep_alive_ { };
+    mutable bool is_parsed_stale { false };
+};
+
+using header_map = basic_header_map<std::string>;
+using header_view_map = basic_header_map<std::string_view>;
+
+} // namespace fhttp
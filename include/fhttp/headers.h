@@ -17,4 +17,20 @@ namespace fhttp {
     inline static constexpr const char* HEADER_CACHE_CONTROL = "Cache-Control";
     inline static constexpr const char* HEADER_ORIGIN = "Origin";
     inline static constexpr const char* HEADER_REFERER = "Referer";
+    inline static constexpr const char* HEADER_RANGE = "Range";
+    inline static constexpr const char* HEADER_IF_RANGE = "If-Range";
+    inline static constexpr const char* HEADER_CONTENT_RANGE = "Content-Range";
+    inline static constexpr const char* HEADER_ACCEPT_RANGES = "Accept-Ranges";
+    inline static constexpr const char* HEADER_ETAG = "ETag";
+    inline static constexpr const char* HEADER_LAST_MODIFIED = "Last-Modified";
+    inline static constexpr const char* HEADER_COOKIE = "Cookie";
+    inline static constexpr const char* HEADER_TRANSFER_ENCODING = "Transfer-Encoding";
+    inline static constexpr const char* HEADER_SERVER = "Server";
+    inline static constexpr const char* HEADER_AUTHORIZATION = "Authorization";
+    inline static constexpr const char* HEADER_IF_NONE_MATCH = "If-None-Match";
+    inline static constexpr const char* HEADER_IF_MODIFIED_SINCE = "If-Modified-Since";
+    inline static constexpr const char* HEADER_EXPECT = "Expect";
+    inline static constexpr const char* HEADER_DATE = "Date";
+    inline static constexpr const char* HEADER_ALLOW = "Allow";
+    inline static constexpr const char* HEADER_VARY = "Vary";
 }
\ No newline at end of file
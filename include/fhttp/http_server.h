@@ -11,13 +11,25 @@
 #include <format>
 #include <regex>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <span>
 
 #include "request.h"
+#include "request_view.h"
 #include "request_parser.h"
+#include "arena.h"
+#include "errors.h"
+#include "header_filter.h"
 #include "response.h"
 #include "meta.h"
 #include "logging.h"
 #include "cookies.h"
+#include "buffer_pool.h"
+#include "static_files.h"
+#include "perfect_hash.h"
+#include "path_pattern.h"
+#include "status_codes.h"
 #include "data/data.h"
 
 #include <tuple>
@@ -40,6 +52,12 @@ const char* get_handler_description() {
     }
 }
 
+template <typename T, typename = void>
+struct has_prepare_body : std::false_type {};
+
+template <typename T>
+struct has_prepare_body<T, std::void_t<decltype(&T::prepare_body)>> : std::true_type {};
+
 struct handler_context {
     std::function<void()> handle_request;
 };
@@ -67,91 +85,599 @@ struct http_handler {
         ctx.handle_request();
     }
 
+    void evaluate_request(fhttp::handler_context& ctx, const fhttp::request_view&, fhttp::response<std::string>&) {
+        ctx.handle_request();
+    }
+
 };
 
 
+/// @brief Whether a route path has no regex syntax, such path is matched by comparing strings (a '.' alone doesn't
+/// count, "/openapi.json" is meant literally)
+constexpr bool is_literal_path(std::string_view path) {
+    return path.find_first_of("[](){}*+?^$|\\") == std::string_view::npos;
+}
+
+/// @brief Content-Type & Accept when the handler's request or response body is `json<T>`, the format of such
+/// bodies is negotiated per request
+template <typename handler_t>
+constexpr header_filter body_format_headers_of() {
+    using definition = handler_type_definition<&handler_t::handle>;
+    using request_t = std::remove_cvref_t<typename definition::request_t>;
+    using response_t = std::remove_cvref_t<typename definition::response_t>;
+
+    if constexpr (has_body_format<typename request_t::body_type> or has_body_format<typename response_t::body_type>) {
+        return body_format_headers;
+    } else {
+        return header_filter::of({ });
+    }
+}
+
 template <label_literal path, method method_, typename handler_t>
 struct route {
     using handler_type = handler_t;
     static constexpr const char* path_value = path.c_str();
     static constexpr method method_value = method_;
+    static constexpr header_filter request_header_filter = request_headers_of<handler_type>().merged(body_format_headers_of<handler_type>());
+    /// Literal routes are looked up by the router's perfect hash, only the others need to be matched
+    static constexpr bool is_literal = is_literal_path(path.c_str());
+    /// Pattern routes ("/users/{id:int}") are matched segment by segment, only the rest needs the regex
+    static constexpr bool is_pattern = is_pattern_path(path.c_str());
+    static constexpr bool is_regex = not is_literal and not is_pattern;
+
+    using pattern_type = std::conditional_t<is_pattern, path_pattern<path>, void>;
 
     template <typename global_data_t, typename config_t>
     constexpr static bool handle_request(request<std::string>& req, response<std::string>& resp, global_data_t& global_data, const config_t& config) {
-        const auto [matched, regex_groups] = matches(req.path, req.method);
-        if (not matched) {
+        if (not matches(req)) {
             return false;
         }
 
-        req.url_matches = regex_groups;
+        handle_matched_request(req, resp, global_data, config);
+        return true;
+    }
 
-        using handler_definition = handler_type_definition<&handler_type::handle>;
+    /// @brief Handles a request the router already matched to this route (url_matches / path_params are set)
+    template <typename global_data_t, typename config_t>
+    static void handle_matched_request(request<std::string>& req, response<std::string>& resp, global_data_t& global_data, const config_t& config) {
+        if constexpr (std::is_same_v<request_type, request_view>) {
+            /* Request didn't arrive within a single read, handler still gets a view, just of the owned request */
+            auto view = view_of(req);
+            if constexpr (is_regex) {
+                boost::regex_match(view.path.begin(), view.path.end(), view.url_matches, expression());
+            }
+            invoke_handler(view, resp, global_data, config);
+        } else {
+            invoke_handler(req, resp, global_data, config);
+        }
+    }
 
-        FHTTP_LOG(INFO) << "Calling a handler with description: " << get_handler_description<handler_type>();
-        handler_type handler {config, global_data};
+    /// @brief Same as handle_request, for a request that's still just a view of the read buffer. Handler taking
+    /// a `request_view` gets it as is, any other handler gets an owned copy (only once the route matched).
+    template <typename global_data_t, typename config_t>
+    static bool handle_view(request_view& req, response<std::string>& resp, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) {
+        if (not matches(req)) {
+            return false;
+        }
 
-        std::remove_reference_t<typename handler_definition::response_t> converted_response {};
-        const auto converted_request = convert_request<
-            typename std::remove_reference_t<typename handler_definition::request_t>::body_type,
-            typename std::remove_reference_t<typename handler_definition::request_t>::query_params_type
-        >(req);
+        handle_matched_view(req, resp, global_data, config, spill_threshold);
+        return true;
+    }
 
-        handler_context handler_ctx {
-            [&handler, &converted_request, &converted_response] {
-                handler.handle(converted_request, converted_response);
+    template <typename global_data_t, typename config_t>
+    static void handle_matched_view(request_view& req, response<std::string>& resp, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) {
+        if constexpr (std::is_same_v<request_type, request_view> or converts_view) {
+            FHTTP_UNUSED(spill_threshold);
+            invoke_handler(req, resp, global_data, config);
+        } else {
+            auto owned = req.to_request();
+            if constexpr (is_regex) {
+                boost::regex_match(owned.path, owned.url_matches, expression());
             }
-        };
 
-        handler.evaluate_request(handler_ctx, req, resp);
+            if (not req.body.empty()) {
+                setup_body(owned, spill_threshold);
+                if (owned.body_stream) {
+                    owned.body_stream.write(req.body);
+                    owned.body.clear();
+                }
+            }
+
+            invoke_handler(owned, resp, global_data, config);
+        }
+    }
 
-        resp = convert_to_string_response(converted_response);
+    /// @brief Called once headers of a request with a body are parsed, if this route is the one handling the request
+    /// and its handler takes a streaming_body, the body is redirected into a stream. Returns whether the route matched.
+    template <typename global_data_t, typename config_t>
+    static bool prepare_body(request<std::string>& req, global_data_t&, const config_t&, std::size_t spill_threshold) {
+        if (not matches(req)) {
+            return false;
+        }
+
+        setup_body(req, spill_threshold);
         return true;
     }
 
+    template <typename global_data_t, typename config_t>
+    static void prepare_matched_body(request<std::string>& req, global_data_t&, const config_t&, std::size_t spill_threshold) {
+        setup_body(req, spill_threshold);
+    }
+
+    /// @brief Whether the path matches regardless of the method, used to tell 405 from 404
+    static bool matches_path(std::string_view path_to_match) {
+        if constexpr (is_literal) {
+            return path_to_match == path.c_str();
+        } else if constexpr (is_pattern) {
+            path_params params { };
+            return pattern_type::match(path_to_match, params);
+        } else {
+            return boost::regex_match(path_to_match.begin(), path_to_match.end(), expression());
+        }
+    }
+
 private:
-    static std::pair<bool, boost::smatch> matches(const std::string& path_to_match, method method) {
-        boost::smatch what;
+    using handler_definition = handler_type_definition<&handler_type::handle>;
+    using request_type = std::remove_cvref_t<typename handler_definition::request_t>;
 
-        if (method != method_value) {
-            return {false, what};
+    using response_type = std::remove_cvref_t<typename handler_definition::response_t>;
+
+    /// Typed request can be made straight from a view (instead of an owned copy) unless the handler needs what only
+    /// the owned request has (streamed body, regex matches), or its middleware takes only owned requests
+    static constexpr bool converts_view = [] {
+        if constexpr (std::is_same_v<request_type, request_view>) {
+            return false;
+        } else if constexpr (request_type::is_owning or is_regex) {
+            return false;
+        } else {
+            return not std::is_same_v<typename request_type::body_type, streaming_body>
+                and requires (handler_type& handler, handler_context& ctx, const request_view& view, response<std::string>& resp) {
+                    handler.evaluate_request(ctx, view, resp);
+                };
+        }
+    }();
+
+    template <typename request_t, typename global_data_t, typename config_t>
+    static void invoke_handler(request_t& req, response<std::string>& resp, global_data_t& global_data, const config_t& config) {
+        if constexpr (not std::is_same_v<request_type, request_view>) {
+            if constexpr (std::is_same_v<typename request_type::body_type, streaming_body>) {
+                /* Handler would get a truncated body */
+                if (req.body_stream.is_failed()) {
+                    set_error_response(resp, request_error::internal_error, "Request body couldn't be stored");
+                    return;
+                }
+            }
         }
 
-        /// Note: regex expression, can be static, so we won't compile it every time
-        /// BUT, not sure if it's thread safe
-        static const boost::regex expression { path_value };
+        FHTTP_LOG(INFO) << "Calling a handler with description: " << get_handler_description<handler_type>();
+        handler_type handler {config, global_data};
 
-        if (!boost::regex_match(path_to_match, what, expression)) {
-            return {false, what};
+        if constexpr (std::is_same_v<request_type, request_view>) {
+            handler_context handler_ctx {
+                [&handler, &req, &resp] {
+                    respond(handler, req, resp);
+                }
+            };
+
+            if constexpr (requires { handler.evaluate_request(handler_ctx, std::as_const(req), resp); }) {
+                handler.evaluate_request(handler_ctx, std::as_const(req), resp);
+            } else {
+                /* Middleware works with owned requests only, so it gets a copy */
+                auto owned = req.to_request();
+                handler.evaluate_request(handler_ctx, owned, resp);
+            }
+        } else if constexpr (std::is_same_v<request_type, request<std::string>>) {
+            /* Handler takes the parsed request as it is */
+            handler_context handler_ctx {
+                [&handler, &req, &resp] {
+                    respond(handler, req, resp);
+                }
+            };
+
+            handler.evaluate_request(handler_ctx, req, resp);
+        } else {
+            /* Typed request is made only once middleware lets the request through, it views the parsed one */
+            handler_context handler_ctx {
+                [&handler, &req, &resp] {
+                    using path_params_t = typename request_type::path_params_type;
+                    using query_params_t = typename request_type::query_params_type;
+
+                    boost::system::error_code body_error { };
+                    auto converted_request = convert_request<
+                        typename request_type::body_type,
+                        typename request_type::query_params_type,
+                        path_params_t
+                    >(req, body_error);
+
+                    if (body_error) {
+                        set_error_response(resp, request_error::invalid_body, std::format("Invalid request body: {}", body_error.message()));
+                        return;
+                    }
+
+                    if constexpr (not std::is_same_v<path_params_t, path_params>) {
+                        static_assert(is_pattern, "typed path parameters need a route pattern, e.g. /users/{id:int}");
+                        std::string_view invalid { };
+                        auto typed_path_params = pattern_type::template to_data_pack<path_params_t>(req.path_params, &invalid);
+                        if (not typed_path_params) {
+                            set_error_response(resp, request_error::invalid_path_parameter,
+                                std::format("Value of path parameter '{}' is out of range", invalid));
+                            return;
+                        }
+                        converted_request.path_params = std::move(*typed_path_params);
+                    }
+
+                    /* values are decoded in a copy in the arena, the request's query stays the raw one */
+                    std::pmr::string decoded_query { req.arena };
+                    if constexpr (is_query_params_v<query_params_t>) {
+                        decoded_query.assign(req.query);
+                        const auto parsed = parse_query(decoded_query, converted_request.query_params);
+                        if (not parsed) {
+                            set_error_response(resp, request_error::invalid_query_parameter,
+                                std::format("Invalid value of query parameter '{}'", parsed.field));
+                            return;
+                        }
+                    }
+
+                    respond(handler, converted_request, resp);
+                }
+            };
+
+            if constexpr (std::is_same_v<request_t, request_view>) {
+                handler.evaluate_request(handler_ctx, std::as_const(req), resp);
+            } else {
+                handler.evaluate_request(handler_ctx, req, resp);
+            }
         }
+    }
+
+    /// @brief Calls the handler, typed response is serialized straight into `resp`
+    template <typename request_t>
+    static void respond(handler_type& handler, request_t& req, response<std::string>& resp) {
+        if constexpr (std::is_same_v<response_type, response<std::string>>) {
+            handler.handle(req, resp);
+        } else {
+            response_type typed_response { };
+            if constexpr (has_fieldset<typename response_type::body_type>) {
+                /* `?fields=` is compiled into the fieldset before the handler runs, an unknown field is a 400 */
+                using fieldset_t = datalib::fieldset<typename response_type::body_type::inner_t>;
+                std::optional<fieldset_t> fields { };
+                std::pmr::string selector { req.arena };
+                if (const auto raw = req.query_fields().get(fields_query_parameter)) {
+                    selector.assign(*raw);
+                    selector.resize(percent_decode(selector.data(), selector.size()));
+                    std::string_view unknown { };
+                    fields = fieldset_t::parse(selector, &unknown);
+                    if (not fields) {
+                        set_error_response(resp, request_error::invalid_query_parameter,
+                            std::format("Unknown field '{}' in '{}'", unknown, fields_query_parameter));
+                        return;
+                    }
+                }
+
+                handler.handle(req, typed_response);
+                const auto format = accepted_body_format(req.headers.get(known_header::accept));
+                if (fields) {
+                    write_response(std::move(typed_response), resp, format, *fields);
+                } else {
+                    write_response(std::move(typed_response), resp, format);
+                }
+            } else if constexpr (has_body_format<typename response_type::body_type>) {
+                handler.handle(req, typed_response);
+                write_response(std::move(typed_response), resp, accepted_body_format(req.headers.get(known_header::accept)));
+            } else {
+                handler.handle(req, typed_response);
+                write_response(std::move(typed_response), resp);
+            }
+        }
+    }
+
+    static void setup_body(request<std::string>& req, std::size_t spill_threshold) {
+        using body_t = typename request_type::body_type;
+
+        if constexpr (std::is_same_v<body_t, streaming_body>) {
+            req.body_stream = streaming_body { spill_threshold };
+
+            /* Handler may want to consume chunks directly as they come instead of having them buffered. No handler
+               instance exists yet (the one handling the request is made once the body is complete), so chunk
+               handlers can't capture one. */
+            if constexpr (has_prepare_body<handler_type>::value) {
+                static_assert(not std::is_member_function_pointer_v<decltype(&handler_type::prepare_body)>,
+                    "prepare_body has to be static, chunk handlers it installs outlive any handler instance");
+                handler_type::prepare_body(std::as_const(req), req.body_stream);
+            }
+        } else {
+            FHTTP_UNUSED(req);
+            FHTTP_UNUSED(spill_threshold);
+        }
+    }
+
+    /// Note: regex expression, can be static, so we won't compile it every time
+    /// BUT, not sure if it's thread safe
+    static const boost::regex& expression() {
+        static const boost::regex instance { path_value };
+        return instance;
+    }
 
-        return {true, what};
+    /// @brief Matches method & path, fills url_matches (regex) or path_params (pattern) of the request
+    template <typename request_t>
+    static bool matches(request_t& req) {
+        if (req.method != method_value) {
+            return false;
+        }
+
+        if constexpr (is_literal) {
+            return req.path == path.c_str();
+        } else if constexpr (is_pattern) {
+            return pattern_type::match(req.path, req.path_params);
+        } else {
+            return boost::regex_match(req.path.cbegin(), req.path.cend(), req.url_matches, expression());
+        }
     }
 };
 
 
-template <typename... Ts>
-struct router;
+/// @brief Dispatches requests to routes. The route table is built at compile time: literal paths go into a
+/// perfect hash whose entry has one route per method, so a literal route is found with a single hash & compare
+/// however many routes there are. Only routes that need it (regex, static files prefix) are tried one by one,
+/// and only those registered for the request's method. Literal routes take precedence over the others, among
+/// routes of the same kind the first one wins. Unmatched requests get 405 (with Allow) when the path exists
+/// under another method, 404 otherwise.
+template <typename... routes_t>
+struct router {
+    using route_ts = std::tuple<routes_t...>;
+
+    /// Union of headers read by the handlers, the parser doesn't store any other
+    static constexpr header_filter request_header_filter = [] {
+        header_filter filter = framework_headers;
+        ((filter = filter.merged(routes_t::request_header_filter)), ...);
+        return filter;
+    }();
 
-template <typename route_t, typename ... Ts>
-struct router<route_t, Ts...> : public router<Ts...> {
-    using route_ts = std::tuple<route_t, Ts...>;
-    
     template <typename global_data_t, typename config_t>
     bool handle_request(request<std::string>& req, response<std::string>& resp, global_data_t& global_data, const config_t& config) const {
-        if (route_t::handle_request(req, resp, global_data, config)) {
+        using matched_handler_t = void (*)(request<std::string>&, response<std::string>&, global_data_t&, const config_t&);
+        using handler_t = bool (*)(request<std::string>&, response<std::string>&, global_data_t&, const config_t&);
+
+        static constexpr std::array<matched_handler_t, route_count> matched_handlers {
+            &dispatch_matched_request<routes_t, global_data_t, config_t>...
+        };
+        static constexpr std::array<handler_t, route_count> handlers {
+            &routes_t::template handle_request<global_data_t, config_t>...
+        };
+
+        /* Request with a body was matched already when its headers got parsed */
+        if (req.matched_route) {
+            matched_handlers[*req.matched_route](req, resp, global_data, config);
+            return true;
+        }
+
+        const auto literal = find_literal(req.path, req.method);
+        if (literal.route != no_route) {
+            matched_handlers[literal.route](req, resp, global_data, config);
             return true;
         }
 
-        return router<Ts...>::handle_request(req, resp, global_data, config);
+        for (const auto index : fallback_routes_of(req.method)) {
+            if (handlers[index](req, resp, global_data, config)) {
+                return true;
+            }
+        }
+
+        reject(req.path, literal.path, resp);
+        return false;
     }
-};
 
-template <>
-struct router<> {
     template <typename global_data_t, typename config_t>
-    bool handle_request(request<std::string>&, response<std::string>&, global_data_t&, const config_t&) const {
+    bool handle_view(request_view& req, response<std::string>& resp, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) const {
+        using matched_handler_t = void (*)(request_view&, response<std::string>&, global_data_t&, const config_t&, std::size_t);
+        using handler_t = bool (*)(request_view&, response<std::string>&, global_data_t&, const config_t&, std::size_t);
+
+        static constexpr std::array<matched_handler_t, route_count> matched_handlers {
+            &dispatch_matched_view<routes_t, global_data_t, config_t>...
+        };
+        static constexpr std::array<handler_t, route_count> handlers {
+            &routes_t::template handle_view<global_data_t, config_t>...
+        };
+
+        const auto literal = find_literal(req.path, req.method);
+        if (literal.route != no_route) {
+            matched_handlers[literal.route](req, resp, global_data, config, spill_threshold);
+            return true;
+        }
+
+        for (const auto index : fallback_routes_of(req.method)) {
+            if (handlers[index](req, resp, global_data, config, spill_threshold)) {
+                return true;
+            }
+        }
+
+        reject(req.path, literal.path, resp);
         return false;
     }
+
+    template <typename global_data_t, typename config_t>
+    bool prepare_body(request<std::string>& req, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) const {
+        using matched_handler_t = void (*)(request<std::string>&, global_data_t&, const config_t&, std::size_t);
+        using handler_t = bool (*)(request<std::string>&, global_data_t&, const config_t&, std::size_t);
+
+        static constexpr std::array<matched_handler_t, route_count> matched_handlers {
+            &dispatch_matched_body<routes_t, global_data_t, config_t>...
+        };
+        static constexpr std::array<handler_t, route_count> handlers {
+            &routes_t::template prepare_body<global_data_t, config_t>...
+        };
+
+        const auto literal = find_literal(req.path, req.method);
+        if (literal.route != no_route) {
+            matched_handlers[literal.route](req, global_data, config, spill_threshold);
+            req.matched_route = literal.route;
+            return true;
+        }
+
+        for (const auto index : fallback_routes_of(req.method)) {
+            if (handlers[index](req, global_data, config, spill_threshold)) {
+                req.matched_route = index;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    template <typename route_t>
+    static constexpr bool is_literal_route() {
+        if constexpr (requires { route_t::is_literal; }) {
+            return route_t::is_literal;
+        } else {
+            return false;
+        }
+    }
+
+    /* Entries of the dispatch tables for routes that are matched already: literal routes, and any route for an
+       owned request matched at its body start (its url_matches / path_params are set). Routes without
+       handle_matched_request (static files) just check their prefix again. */
+    template <typename route_t, typename global_data_t, typename config_t>
+    static void dispatch_matched_request(request<std::string>& req, response<std::string>& resp, global_data_t& global_data, const config_t& config) {
+        if constexpr (requires { route_t::template handle_matched_request<global_data_t, config_t>(req, resp, global_data, config); }) {
+            route_t::handle_matched_request(req, resp, global_data, config);
+        } else {
+            route_t::handle_request(req, resp, global_data, config);
+        }
+    }
+
+    template <typename route_t, typename global_data_t, typename config_t>
+    static void dispatch_matched_view(request_view& req, response<std::string>& resp, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) {
+        if constexpr (is_literal_route<route_t>()) {
+            route_t::handle_matched_view(req, resp, global_data, config, spill_threshold);
+        }
+    }
+
+    template <typename route_t, typename global_data_t, typename config_t>
+    static void dispatch_matched_body(request<std::string>& req, global_data_t& global_data, const config_t& config, std::size_t spill_threshold) {
+        if constexpr (is_literal_route<route_t>()) {
+            route_t::prepare_matched_body(req, global_data, config, spill_threshold);
+        }
+    }
+
+    static constexpr std::size_t route_count = sizeof...(routes_t);
+    static constexpr std::size_t method_count = static_cast<std::size_t>(method::connect) + 1;
+    static constexpr std::uint16_t no_route = 0xffff;
+
+    static_assert(route_count < no_route, "too many routes");
+
+    static constexpr std::array<std::string_view, route_count> paths { std::string_view { routes_t::path_value }... };
+    static constexpr std::array<method, route_count> methods { routes_t::method_value... };
+    static constexpr std::array<bool, route_count> literals { is_literal_route<routes_t>()... };
+
+    static constexpr std::size_t literal_path_count = [] {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < route_count; ++i) {
+            bool is_new = literals[i];
+            for (std::size_t j = 0; j < i and is_new; ++j) {
+                is_new = not (literals[j] and paths[j] == paths[i]);
+            }
+            count += is_new;
+        }
+        return count;
+    }();
+
+    static constexpr perfect_hash<literal_path_count> literal_paths { [] {
+        std::array<std::string_view, literal_path_count> unique { };
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < route_count; ++i) {
+            if (literals[i] and std::find(unique.begin(), unique.begin() + count, paths[i]) == unique.begin() + count) {
+                unique[count++] = paths[i];
+            }
+        }
+        return unique;
+    }() };
+
+    /* literal path -> method -> route */
+    static constexpr auto literal_routes = [] {
+        std::array<std::array<std::uint16_t, method_count>, literal_path_count> table { };
+        for (auto& by_method : table) {
+            by_method.fill(no_route);
+        }
+        for (std::size_t i = 0; i < route_count; ++i) {
+            if (not literals[i]) {
+                continue;
+            }
+            auto& entry = table[literal_paths.find(paths[i])][static_cast<std::size_t>(methods[i])];
+            if (entry == no_route) {
+                entry = static_cast<std::uint16_t>(i);
+            }
+        }
+        return table;
+    }();
+
+    /* method -> routes that have to be tried one by one, in declaration order */
+    struct fallback_table {
+        std::array<std::array<std::uint16_t, route_count>, method_count> routes { };
+        std::array<std::size_t, method_count> sizes { };
+    };
+
+    static constexpr fallback_table fallback_routes = [] {
+        fallback_table table { };
+        for (std::size_t i = 0; i < route_count; ++i) {
+            if (not literals[i]) {
+                const auto m = static_cast<std::size_t>(methods[i]);
+                table.routes[m][table.sizes[m]++] = static_cast<std::uint16_t>(i);
+            }
+        }
+        return table;
+    }();
+
+    static std::span<const std::uint16_t> fallback_routes_of(method method) {
+        const auto m = static_cast<std::size_t>(method);
+        return { fallback_routes.routes[m].data(), fallback_routes.sizes[m] };
+    }
+
+    struct literal_match {
+        /* index into literal_routes, npos if the path is not a literal route path */
+        std::size_t path;
+        std::uint16_t route;
+    };
+
+    static literal_match find_literal(std::string_view path, method method) {
+        const auto index = literal_paths.find(path);
+        if (index == perfect_hash<literal_path_count>::npos) {
+            return { index, no_route };
+        }
+        return { index, literal_routes[index][static_cast<std::size_t>(method)] };
+    }
+
+    /// @brief Response for a request no route accepted: 405 listing the methods the path is available with, or 404
+    static void reject(std::string_view path, std::size_t literal_path, response<std::string>& resp) {
+        using path_matcher_t = bool (*)(std::string_view);
+        static constexpr std::array<path_matcher_t, route_count> path_matchers { &routes_t::matches_path... };
+
+        std::array<bool, method_count> allowed { };
+        if (literal_path != perfect_hash<literal_path_count>::npos) {
+            for (std::size_t m = 0; m < method_count; ++m) {
+                allowed[m] = literal_routes[literal_path][m] != no_route;
+            }
+        }
+        for (std::size_t i = 0; i < route_count; ++i) {
+            if (not literals[i] and not allowed[static_cast<std::size_t>(methods[i])] and path_matchers[i](path)) {
+                allowed[static_cast<std::size_t>(methods[i])] = true;
+            }
+        }
+
+        std::string allow;
+        for (std::size_t m = 0; m < method_count; ++m) {
+            if (allowed[m]) {
+                allow += allow.empty() ? "" : ", ";
+                allow += method_to_string(static_cast<method>(m));
+            }
+        }
+
+        if (allow.empty()) {
+            resp.status_code = STATUS_CODE_NOT_FOUND;
+        } else {
+            resp.status_code = STATUS_CODE_METHOD_NOT_ALLOWED;
+            resp.headers[HEADER_ALLOW] = std::move(allow);
+        }
+    }
 };
 
 }
@@ -160,14 +686,35 @@ struct query_params {};
 
 namespace fhttp {
 
+using request_handler_t = std::function<void(request<std::string>&, response<std::string>&)>;
+using view_handler_t = std::function<void(request_view&, response<std::string>&)>;
+using body_start_handler_t = std::function<void(request<std::string>&)>;
+
 struct connection : std::enable_shared_from_this<connection> {
-    connection(boost::asio::io_service& io_service, std::function<void(request<std::string>&, response<std::string>&)>&& handle_request, const std::string& server_header);
+    connection(boost::asio::io_service& io_service, request_handler_t&& handle_request, view_handler_t&& handle_view, body_start_handler_t&& prepare_body, const std::string& server_header);
     void start();
     void set_keep_alive_timeout(std::chrono::steady_clock::duration timeout);
+    void set_max_chunk_size(std::size_t size);
+    void set_max_body_size(std::size_t size);
+    void set_header_filter(const header_filter* filter);
     boost::asio::ip::tcp::socket& get_socket();
 
+    /// @brief Brings connection back to the freshly constructed state, so it can be reused for another client
+    void reset();
+
 private:
-    void handle_read(const boost::system::error_code& e, std::size_t bytes_read);
+    void handle_readable(const boost::system::error_code& e);
+    void handle_read(const char* begin, const char* end);
+    void dispatch_request();
+    void dispatch_view();
+    void queue_response(response<std::string>&& response, int http_version_major, int http_version_minor, bool close_requested);
+    void reset_request();
+    void release_pending_responses();
+    void write_pending_responses();
+    void write_next_chunk();
+    void send_file();
+    bool send_file_region(file_region& region);
+    void handle_writable(const boost::system::error_code& e);
     void listen_again();
     void post_response_sent(const boost::system::error_code& e);
     void close_socket();
@@ -182,10 +729,54 @@ private:
     boost::asio::io_service::strand strand;
 
     boost::asio::ip::tcp::socket socket;
-    std::array<char, 1024*8> buffer {  };
+
+    /* Read buffer is leased from the thread's buffer_pool only once the socket is readable, idle
+       keep-alive connections don't hold any, size grows for clients sending large requests */
+    std::size_t read_buffer_size { default_read_buffer_size };
+    static constexpr std::size_t default_read_buffer_size = 8 * 1024;
+
     request<std::string> current_request { };
     request_parser parser { };
-    std::function<void(request<std::string>&, response<std::string>&)> handle_request;
+
+    /* Request that arrived whole within a single read, it's parsed into views of the read buffer,
+       which stays leased until the request is handled */
+    request_view current_view { };
+
+    /* Headers worth storing, others are skipped by the parser */
+    const header_filter* request_header_filter { nullptr };
+    std::size_t max_body_size { request_parser::default_max_body_size };
+
+    /* Responses of (possibly pipelined) requests parsed from a single read, sent back in order with one write */
+    std::vector<response<std::string>> pending_responses { };
+
+    /* Memory of the requests whose responses are pending, released at once when they are all written */
+    request_arena arena { };
+
+    /* Bodies of written responses are reused for the next ones, so serializing a response doesn't need malloc */
+    std::vector<std::string> recycled_bodies { };
+    static constexpr std::size_t max_recycled_bodies = 4;
+    static constexpr std::size_t max_recycled_body_capacity = 16 * 1024;
+
+    /* Status lines & headers of all pending responses, reused between writes, bodies are never copied in here */
+    std::string header_buffer { };
+    std::vector<std::size_t> header_sizes { };
+    std::vector<boost::asio::const_buffer> pending_buffers { };
+    std::size_t next_pending_response { 0 };
+
+    /* Streamed (response_stream) response currently being written, next piece is produced only once the previous one was sent */
+    bool is_streaming_response { false };
+    std::string chunk_buffer { };
+    std::string chunk_header_buffer { };
+    /* Bytes of it produced so far, checked against the content_length the head declared */
+    std::size_t streamed_body_size { 0 };
+
+    /* Response with a file body (body_file) currently being sent, part by part */
+    bool is_sending_file { false };
+    std::size_t file_part { 0 };
+    bool is_file_part_prefix_sent { false };
+
+    request_handler_t handle_request;
+    view_handler_t handle_view;
     bool should_stop { false };
 
     boost::asio::steady_timer keep_alive_timer;
@@ -195,6 +786,29 @@ private:
 
 };
 
+/// @brief Free list of connections, connection is put back (and reset) once nothing references it anymore,
+/// so accepting a client doesn't need to allocate socket, timer, buffers... every time
+struct connection_pool : std::enable_shared_from_this<connection_pool> {
+    connection_pool(boost::asio::io_service& io_service, request_handler_t handle_request, view_handler_t handle_view, body_start_handler_t prepare_body, const std::string& server_header, std::size_t max_size);
+
+    /// @brief Takes a connection from the pool (or creates a new one if the pool is empty)
+    std::shared_ptr<connection> acquire();
+
+private:
+    void release(connection* conn);
+
+private:
+    boost::asio::io_service& io_service;
+    request_handler_t handle_request;
+    view_handler_t handle_view;
+    body_start_handler_t prepare_body;
+    const std::string& server_header;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<connection>> free_connections;
+    std::size_t max_size;
+};
+
 struct none_config { };
 
 template <typename state_t, typename config_t>
@@ -235,23 +849,34 @@ auto create_tuple_from_types(const config_t& config) {
     return create_tuple_from_types<Tuple, config_t>(config, std::make_index_sequence<N>{});
 }
 
+/// @brief Pins the calling thread to the given CPU (no-op on platforms without thread affinity)
+void pin_current_thread(std::size_t cpu);
+
+/// @brief Acceptor together with the io_service its accepted connections are going to live on
+struct acceptor_shard {
+    explicit acceptor_shard(boost::asio::io_service& io_service)
+        : io_service { io_service }
+        , acceptor { io_service }
+    { }
+
+    boost::asio::io_service& io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+    std::shared_ptr<connection_pool> connection_pool;
+    std::shared_ptr<connection> connection_instance;
+};
+
 template <typename router_t, typename config_t = none_config, typename global_state_tuple_t = std::tuple<>, typename thread_local_state_tuple_t = std::tuple<>>
 struct server {
     using this_t = server<router_t, config_t, global_state_tuple_t, thread_local_state_tuple_t>;
 
     server(const std::string& host, const uint16_t port, const config_t& config = config_t { }) : 
         config { config },
-        acceptor { io_service },
         signals(io_service, SIGINT, SIGTERM),
         graceful_shutdown_timer(io_service, graceful_shutdown_seconds)
     {
         boost::asio::ip::tcp::resolver resolver(io_service);
         boost::asio::ip::tcp::resolver::query query(host, std::to_string(port));
-        boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
-        acceptor.open(endpoint.protocol());
-        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
+        endpoint = *resolver.resolve(query);
 
         initialize_global_state();
 
@@ -273,6 +898,10 @@ struct server {
     void shutdown() {
         FHTTP_LOG(INFO) << "Shutting down server";
         io_service.stop();
+
+        for (auto& shard_io_service : shard_io_services) {
+            shard_io_service->stop();
+        }
     }
 
     void initialize_global_state() {
@@ -280,19 +909,76 @@ struct server {
 
     }
 
-    void start_accept() {
-        acceptor.async_accept(
-            connection_instance->get_socket(), 
-            boost::bind(&server::handle_accept, this, boost::asio::placeholders::error)
+    void open_acceptor(acceptor_shard& shard) {
+        shard.acceptor.open(endpoint.protocol());
+        shard.acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+
+        if (sharded) {
+#ifdef SO_REUSEPORT
+            /* Every shard binds its own listening socket to the same port, kernel balances connections between them */
+            using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+            shard.acceptor.set_option(reuse_port(true));
+#else
+            FHTTP_LOG(FATAL) << "Sharded mode requires SO_REUSEPORT support";
+#endif
+        }
+
+        shard.acceptor.bind(endpoint);
+        shard.acceptor.listen();
+    }
+
+    void start_accept(acceptor_shard& shard) {
+        shard.acceptor.async_accept(
+            shard.connection_instance->get_socket(), 
+            boost::bind(&server::handle_accept, this, boost::ref(shard), boost::asio::placeholders::error)
         );
     }
 
     void start() {
-        initial_connection_instance();
-        
+        if (sharded) {
+            for (std::size_t n = 0; n < n_threads; ++n) {
+                /* Only a single thread ever runs the shard's io_service */
+                shard_io_services.push_back(std::make_unique<boost::asio::io_service>(1));
+                shards.push_back(std::make_unique<acceptor_shard>(*shard_io_services.back()));
+            }
+        } else {
+            shards.push_back(std::make_unique<acceptor_shard>(io_service));
+        }
+
+        for (auto& shard : shards) {
+            open_acceptor(*shard);
+            shard->connection_pool = std::make_shared<connection_pool>(shard->io_service, [this] (request<std::string>& req, response<std::string>& resp) {
+                return router_instance.handle_request(req, resp, unwrap_ref(global_state), this->config);
+            }, [this] (request_view& req, response<std::string>& resp) {
+                return router_instance.handle_view(req, resp, unwrap_ref(global_state), this->config, body_spill_threshold);
+            }, [this] (request<std::string>& req) {
+                router_instance.prepare_body(req, unwrap_ref(global_state), this->config, body_spill_threshold);
+            }, server_header, max_pooled_connections);
+            initial_connection_instance(*shard);
+        }
+
         FHTTP_LOG(INFO) << "Starting a server";
-        start_accept();
-        
+        for (auto& shard : shards) {
+            start_accept(*shard);
+        }
+
+        if (sharded) {
+            for (std::size_t n = 0; n < n_threads; ++n) {
+                threadpool.create_thread([this, n] {
+                    if (pin_threads) {
+                        pin_current_thread(n);
+                    }
+                    shard_io_services[n]->run();
+                });
+            }
+
+            /* Main io_service only takes care of signals & graceful shutdown in sharded mode */
+            threadpool.create_thread(
+                boost::bind(&boost::asio::io_service::run, &io_service)
+            );
+            return;
+        }
+
         for (std::size_t n = 0; n < n_threads; ++n) {
             threadpool.create_thread(
                 boost::bind(&boost::asio::io_service::run, &io_service)
@@ -300,23 +986,24 @@ struct server {
         }
     }
 
-    void initial_connection_instance() {
-        connection_instance = std::make_shared<connection>(io_service, [this] (request<std::string>& req, response<std::string>& resp) {
-            return router_instance.handle_request(req, resp, unwrap_ref(global_state), this->config);
-        }, server_header);
+    void initial_connection_instance(acceptor_shard& shard) {
+        shard.connection_instance = shard.connection_pool->acquire();
     }
 
-    void handle_accept(const boost::system::error_code& e) {
+    void handle_accept(acceptor_shard& shard, const boost::system::error_code& e) {
         if (is_shutting_down) {
             return;
         }
 
         if (!e) {
-            connection_instance->set_keep_alive_timeout(keep_alive_timeout);
-            connection_instance->start();
+            shard.connection_instance->set_keep_alive_timeout(keep_alive_timeout);
+            shard.connection_instance->set_max_chunk_size(max_chunk_size);
+            shard.connection_instance->set_max_body_size(max_body_size);
+            shard.connection_instance->set_header_filter(&router_t::request_header_filter);
+            shard.connection_instance->start();
         }
-        initial_connection_instance();
-        start_accept();
+        initial_connection_instance(shard);
+        start_accept(shard);
     }
 
     void join() {
@@ -331,10 +1018,42 @@ struct server {
         n_threads = n;
     }
 
+    /// @brief Runs one io_service + acceptor (SO_REUSEPORT) per thread instead of sharing a single io_service
+    /// between all threads, connection then stays on the thread that accepted it for its whole life
+    void set_sharded(bool value) {
+        sharded = value;
+    }
+
+    /// @brief In sharded mode pins n-th thread to n-th CPU
+    void set_pin_threads(bool value) {
+        pin_threads = value;
+    }
+
     void set_keep_alive_timeout(std::chrono::steady_clock::duration timeout) {
         keep_alive_timeout = timeout;
     }
 
+    /// @brief Size after which bodies of streaming_body requests (that are not consumed by the handler directly) 
+    /// are moved from memory into a temporary file
+    void set_body_spill_threshold(std::size_t n) {
+        body_spill_threshold = n;
+    }
+
+    /// @brief Maximum size of a single chunk of a chunked request body, requests with bigger chunks are rejected
+    void set_max_chunk_size(std::size_t n) {
+        max_chunk_size = n;
+    }
+
+    /// @brief Maximum size of a request body (Content-Length or all the chunks), bigger requests get 413
+    void set_max_body_size(std::size_t n) {
+        max_body_size = n;
+    }
+
+    /// @brief Maximum number of idle connection objects kept for reuse (per shard)
+    void set_max_pooled_connections(std::size_t n) {
+        max_pooled_connections = n;
+    }
+
     void set_server_header(const std::string& header) {
         server_header = header;
     }
@@ -342,20 +1061,29 @@ struct server {
 private:
     const config_t& config { };
     boost::asio::io_service io_service;
-    boost::asio::ip::tcp::acceptor acceptor;
+    boost::asio::ip::tcp::endpoint endpoint;
     boost::thread_group threadpool;
-    std::shared_ptr<connection> connection_instance;
     router_t router_instance { };
+
+    /* Sharded mode related */
+    std::vector<std::unique_ptr<boost::asio::io_service>> shard_io_services;
+    std::vector<std::unique_ptr<acceptor_shard>> shards;
+    bool sharded { false };
+    bool pin_threads { false };
     
     /* Shutdown related */
     boost::posix_time::seconds graceful_shutdown_seconds { 0 };
-    bool is_shutting_down { false };
+    std::atomic<bool> is_shutting_down { false };
     boost::asio::signal_set signals;
     boost::asio::deadline_timer graceful_shutdown_timer;
 
     std::chrono::steady_clock::duration keep_alive_timeout { };
 
     size_t n_threads { 1 };
+    size_t max_pooled_connections { 1024 };
+    size_t body_spill_threshold { streaming_body::default_spill_threshold };
+    size_t max_chunk_size { request_parser::default_max_chunk_size };
+    size_t max_body_size { request_parser::default_max_body_size };
 
     std::optional<global_state_tuple_t> global_state { };
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace fhttp {
+
+/// @brief View of a "name=value" list (Cookie header, query string, form body) that's only scanned when
+/// it's accessed, nothing is parsed, copied or allocated up front. Pairs are separated by `separator`,
+/// spaces around names and values are ignored, a pair without '=' has an empty value.
+struct key_value_view {
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    struct iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = key_value_view::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        iterator() = default;
+        iterator(std::string_view rest, char separator);
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto copy = *this;
+            advance();
+            return copy;
+        }
+
+        bool operator==(const iterator& other) const { return is_end == other.is_end and (is_end or rest.data() == other.rest.data()); }
+
+    private:
+        void advance();
+
+        std::string_view rest { };
+        value_type current { };
+        char separator { '&' };
+        bool is_end { true };
+    };
+
+    constexpr key_value_view() = default;
+    constexpr key_value_view(std::string_view raw, char separator) : raw_(raw), separator_(separator) { }
+
+    iterator begin() const { return { raw_, separator_ }; }
+    iterator end() const { return { }; }
+    bool empty() const { return begin() == end(); }
+
+    /// @brief Raw value of the first pair with the name
+    std::optional<std::string_view> get(std::string_view name) const;
+
+    /// @brief Percent-decoded value of the first pair with the name ('+' as a space), only this one value is decoded
+    std::optional<std::string> get_decoded(std::string_view name) const;
+
+    bool contains(std::string_view name) const { return get(name).has_value(); }
+
+    std::string_view raw() const { return raw_; }
+
+private:
+    std::string_view raw_ { };
+    char separator_ { '&' };
+};
+
+/// @brief Fields of a query string or of an application/x-www-form-urlencoded body
+struct url_encoded_fields : key_value_view {
+    constexpr url_encoded_fields() = default;
+    constexpr explicit url_encoded_fields(std::string_view raw) : key_value_view(raw, '&') { }
+};
+
+} // namespace fhttp
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <tuple>
 
 #define FHTTP_UNUSED(x) (void)(x)
 
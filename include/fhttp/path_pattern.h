@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "meta.h"
+#include "data/data.h"
+
+namespace fhttp {
+
+enum class path_param_type : std::uint8_t {
+    string,
+    integer
+};
+
+/// @brief Value of a path parameter, a view of the request path (not percent-decoded), integers
+/// are decoded while the path is matched
+struct path_param {
+    std::string_view name { };
+    path_param_type type { path_param_type::string };
+    std::string_view value { };
+    std::int64_t integer { };
+};
+
+/// @brief Parameters captured by a route pattern, kept inline (no allocation). Values are views of the
+/// request path, valid as long as the request is.
+struct path_params {
+    static constexpr std::size_t capacity = 8;
+
+    const path_param* begin() const { return params.data(); }
+    const path_param* end() const { return params.data() + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const path_param& operator[](std::size_t index) const { return params[index]; }
+
+    const path_param* find(std::string_view name) const {
+        for (const auto& param : *this) {
+            if (param.name == name) {
+                return &param;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief Raw value of the parameter
+    std::optional<std::string_view> get(std::string_view name) const {
+        const auto* param = find(name);
+        return param ? std::optional { param->value } : std::nullopt;
+    }
+
+    /// @brief Decoded value of an `int` parameter
+    std::optional<std::int64_t> get_integer(std::string_view name) const {
+        const auto* param = find(name);
+        if (not param or param->type != path_param_type::integer) {
+            return std::nullopt;
+        }
+        return param->integer;
+    }
+
+    void clear() { count = 0; }
+
+    void push_back(const path_param& param) { params[count++] = param; }
+
+private:
+    std::array<path_param, capacity> params { };
+    std::size_t count { 0 };
+};
+
+namespace detail {
+
+struct path_pattern_segment {
+    /* literal text, or name of the parameter */
+    std::string_view text { };
+    bool is_parameter { false };
+    path_param_type type { path_param_type::string };
+};
+
+constexpr bool is_identifier(std::string_view name) {
+    const auto is_alpha = [](char c) { return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_'; };
+    const auto is_digit = [](char c) { return c >= '0' and c <= '9'; };
+
+    if (name.empty() or not is_alpha(name.front())) {
+        return false;
+    }
+    for (const char c : name) {
+        if (not is_alpha(c) and not is_digit(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* "{name}", "{name:string}" or "{name:int}" */
+constexpr path_pattern_segment parse_pattern_segment(std::string_view segment) {
+    if (segment.find_first_of("{}") == std::string_view::npos) {
+        if (segment.find_first_of("[]()*+?^$|\\") != std::string_view::npos) {
+            throw "regex syntax in a path pattern";
+        }
+        return { segment, false, path_param_type::string };
+    }
+
+    if (segment.size() < 2 or segment.front() != '{' or segment.back() != '}') {
+        throw "path parameter has to be a whole segment, e.g. /users/{id:int}";
+    }
+
+    const auto inner = segment.substr(1, segment.size() - 2);
+    const auto colon = inner.find(':');
+    const auto name = inner.substr(0, colon);
+    const auto type = colon == std::string_view::npos ? std::string_view { "string" } : inner.substr(colon + 1);
+
+    if (not is_identifier(name)) {
+        throw "path parameter name is not an identifier";
+    }
+    if (type == "int") {
+        return { name, true, path_param_type::integer };
+    }
+    if (type == "string") {
+        return { name, true, path_param_type::string };
+    }
+    throw "unknown path parameter type, use int or string";
+}
+
+} // namespace detail
+
+/// @brief Whether a route path is a pattern with parameters (e.g. "/users/{id:int}/posts/{slug}") rather
+/// than a regex, regex quantifiers like "{2}" don't start with a letter
+constexpr bool is_pattern_path(std::string_view path) {
+    if (not path.starts_with('/')) {
+        return false;
+    }
+    for (auto brace = path.find('{'); brace != std::string_view::npos; brace = path.find('{', brace + 1)) {
+        if (brace + 1 < path.size() and detail::is_identifier(path.substr(brace + 1, 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Route path with typed parameters, e.g. "/users/{id:int}/posts/{slug}", parsed at compile time.
+/// Every parameter is a whole segment, `int` parameters only match (64 bit) integers, `string` (the default)
+/// any non-empty segment. Matching splits the path on '/' and compares segments, nothing is allocated.
+template <label_literal pattern>
+struct path_pattern {
+    static constexpr std::string_view value = pattern.c_str();
+
+    static_assert(value.starts_with('/'), "path pattern has to start with '/'");
+
+    static constexpr std::size_t segment_count = static_cast<std::size_t>(std::count(value.begin(), value.end(), '/'));
+
+    static constexpr std::array<detail::path_pattern_segment, segment_count> segments = [] {
+        std::array<detail::path_pattern_segment, segment_count> result { };
+        std::size_t begin = 1;
+        for (auto& segment : result) {
+            const auto end = value.find('/', begin);
+            segment = detail::parse_pattern_segment(value.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return result;
+    }();
+
+    static constexpr std::size_t parameter_count = static_cast<std::size_t>(std::count_if(segments.begin(), segments.end(), [](const auto& segment) {
+        return segment.is_parameter;
+    }));
+
+    static_assert(parameter_count <= path_params::capacity, "too many path parameters");
+
+    /// @brief Position of the parameter among the captured path_params, npos if the pattern has no such parameter
+    static constexpr std::size_t index_of(std::string_view name) {
+        std::size_t index = 0;
+        for (const auto& segment : segments) {
+            if (segment.is_parameter) {
+                if (segment.text == name) {
+                    return index;
+                }
+                ++index;
+            }
+        }
+        return static_cast<std::size_t>(-1);
+    }
+
+    /// @brief Matches the whole path, captured parameters replace the content of `params`
+    static bool match(std::string_view path, path_params& params) {
+        if (not path.starts_with('/')) {
+            return false;
+        }
+
+        params.clear();
+        std::size_t begin = 1;
+
+        for (std::size_t i = 0; i < segment_count; ++i) {
+            const auto end = path.find('/', begin);
+            const bool is_last = i + 1 == segment_count;
+            if (is_last != (end == std::string_view::npos)) {
+                return false;
+            }
+
+            const auto text = path.substr(begin, end - begin);
+            const auto& segment = segments[i];
+
+            if (not segment.is_parameter) {
+                if (text != segment.text) {
+                    return false;
+                }
+            } else {
+                path_param param { segment.text, segment.type, text, 0 };
+                if (text.empty()) {
+                    return false;
+                }
+                if (segment.type == path_param_type::integer) {
+                    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), param.integer);
+                    if (ec != std::errc { } or ptr != text.data() + text.size()) {
+                        return false;
+                    }
+                }
+                params.push_back(param);
+            }
+
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    /// @brief Fills a data_pack whose field labels name parameters of the pattern, integer fields take
+    /// `int` parameters, std::string_view / std::string fields take the raw value. Nothing when an integer
+    /// doesn't fit its field (e.g. 4294967297 into an `int`, -1 into an unsigned one).
+    /// @param invalid set to the name of the parameter that doesn't fit
+    template <typename pack_t>
+    static std::optional<pack_t> to_data_pack(const path_params& params, std::string_view* invalid = nullptr) {
+        pack_t result { };
+        const bool is_valid = std::apply([&params, invalid](auto&... fields) {
+            return (assign_field(fields, params, invalid) and ...);
+        }, result.fields);
+        if (not is_valid) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    /// @brief Path as OpenAPI spells it, "/users/{id}/posts/{slug}"
+    static std::string openapi_path() {
+        std::string result;
+        for (const auto& segment : segments) {
+            result += '/';
+            if (segment.is_parameter) {
+                result += '{';
+                result += segment.text;
+                result += '}';
+            } else {
+                result += segment.text;
+            }
+        }
+        return result;
+    }
+
+private:
+    template <typename field_t>
+    static bool assign_field(field_t& field, const path_params& params, std::string_view* invalid) {
+        using value_t = typename field_t::value_type;
+        constexpr auto index = index_of(field_t::label);
+
+        static_assert(index != static_cast<std::size_t>(-1), "field doesn't name a parameter of the path pattern");
+
+        if constexpr (std::is_integral_v<value_t>) {
+            static_assert(segments_parameter(index).type == path_param_type::integer, "integer field needs an {name:int} parameter");
+            if (not std::in_range<value_t>(params[index].integer)) {
+                if (invalid) {
+                    *invalid = params[index].name;
+                }
+                return false;
+            }
+            field.value = static_cast<value_t>(params[index].integer);
+        } else {
+            field.value = value_t { params[index].value };
+        }
+        return true;
+    }
+
+    static constexpr detail::path_pattern_segment segments_parameter(std::size_t index) {
+        for (const auto& segment : segments) {
+            if (segment.is_parameter and index-- == 0) {
+                return segment;
+            }
+        }
+        return { };
+    }
+};
+
+} // namespace fhttp
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+namespace fhttp {
+
+namespace detail {
+
+constexpr std::uint32_t string_hash(std::string_view key) {
+    std::uint32_t hash = 2166136261u;
+    for (const char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr std::uint32_t mix_hash(std::uint32_t hash) {
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+} // namespace detail
+
+/// @brief Perfect hash over a set of strings known at compile time (hash & displace): key is hashed once,
+/// the hash picks a bucket and the bucket's displacement picks a slot that no other key uses, so a lookup
+/// is a single pass over the key and a single comparison, regardless of the number of keys
+/// @tparam N number of keys, they have to be distinct
+template <std::size_t N>
+struct perfect_hash {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr std::size_t bucket_count = N / 2 + 1;
+    static constexpr std::size_t slot_count = std::bit_ceil(N * 2 + 1);
+
+    static_assert(N < 0xffff, "too many keys for a perfect_hash");
+
+    constexpr explicit perfect_hash(const std::array<std::string_view, N>& keys)
+        : keys(keys)
+    {
+        std::array<std::uint32_t, N> hashes { };
+        std::array<std::size_t, bucket_count> bucket_sizes { };
+        for (std::size_t i = 0; i < N; ++i) {
+            hashes[i] = detail::string_hash(keys[i]);
+            ++bucket_sizes[hashes[i] % bucket_count];
+        }
+
+        /* biggest buckets are placed first, while most of the slots are still free */
+        std::array<std::size_t, bucket_count> order { };
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return bucket_sizes[a] > bucket_sizes[b];
+        });
+
+        for (const auto bucket : order) {
+            if (bucket_sizes[bucket] == 0) {
+                break;
+            }
+            displacements[bucket] = find_displacement(bucket, hashes);
+            for (std::size_t i = 0; i < N; ++i) {
+                if (hashes[i] % bucket_count == bucket) {
+                    slots[slot_of(hashes[i], displacements[bucket])] = static_cast<std::uint16_t>(i + 1);
+                }
+            }
+        }
+    }
+
+    /// @brief Index of the key in the array the table was built from, npos if it's not one of the keys
+    constexpr std::size_t find(std::string_view key) const {
+        if constexpr (N == 0) {
+            return npos;
+        } else {
+            const auto hash = detail::string_hash(key);
+            const auto slot = slots[slot_of(hash, displacements[hash % bucket_count])];
+            if (slot == 0 or keys[slot - 1] != key) {
+                return npos;
+            }
+            return slot - 1u;
+        }
+    }
+
+    std::array<std::string_view, N> keys { };
+    std::array<std::uint32_t, bucket_count> displacements { };
+    /* key index + 1, 0 for an empty slot */
+    std::array<std::uint16_t, slot_count> slots { };
+
+private:
+    static constexpr std::size_t slot_of(std::uint32_t hash, std::uint32_t displacement) {
+        return detail::mix_hash(hash ^ displacement) % slot_count;
+    }
+
+    constexpr std::uint32_t find_displacement(std::size_t bucket, const std::array<std::uint32_t, N>& hashes) const {
+        for (std::uint32_t displacement = 0; displacement < 1'000'000; ++displacement) {
+            std::array<bool, slot_count> taken { };
+            bool fits = true;
+
+            for (std::size_t i = 0; i < N and fits; ++i) {
+                if (hashes[i] % bucket_count != bucket) {
+                    continue;
+                }
+                const auto slot = slot_of(hashes[i], displacement);
+                fits = slots[slot] == 0 and not taken[slot];
+                taken[slot] = true;
+            }
+
+            if (fits) {
+                return displacement;
+            }
+        }
+
+        throw "no perfect hash displacement, two keys are equal or have the same hash";
+    }
+};
+
+} // namespace fhttp
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "perfect_hash.h"
+#include "data/data.h"
+
+namespace fhttp {
+
+/// @brief Percent-decodes `data` in place ('+' is decoded as a space, malformed escapes are kept as they are),
+/// returns the decoded size. Bytes without an escape are skipped 16/32 at a time (SSE2/AVX2).
+std::size_t percent_decode(char* data, std::size_t size);
+
+/// @brief Percent-decoded copy of `value`
+std::string percent_decoded(std::string_view value);
+
+/// @brief Query parameter that selects the fields of a `json<T>` response (sparse fieldset), e.g. `?fields=name,profiles.name`
+inline constexpr std::string_view fields_query_parameter = "fields";
+
+template <typename T>
+constexpr bool is_query_params_v = std::is_base_of_v<datalib::data_pack_base, T>;
+
+struct query_parse_result {
+    bool ok { true };
+    /// Label of the field whose value couldn't be converted
+    std::string_view field { };
+
+    explicit operator bool() const { return ok; }
+};
+
+namespace detail {
+
+template <typename value_t>
+bool parse_query_value(std::string_view text, value_t& value) {
+    if constexpr (std::is_same_v<value_t, bool>) {
+        if (text.empty() or text == "1" or text == "true") {
+            value = true;
+        } else if (text == "0" or text == "false") {
+            value = false;
+        } else {
+            return false;
+        }
+        return true;
+    } else if constexpr (std::is_arithmetic_v<value_t>) {
+        const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc { } and end == text.data() + text.size();
+    } else {
+        value = value_t { text };
+        return true;
+    }
+}
+
+} // namespace detail
+
+/// @brief Fills fields of a data_pack from a query string ("a=1&b=x%20y", without the '?'), field labels are
+/// the parameter names. The only bytes modified in place are the values of parameters that are fields of the pack,
+/// they are percent-decoded there, so std::string_view fields are views of the query buffer. Names are left as they
+/// are (a name with an escape is decoded into a scratch buffer for the lookup), values of other parameters are
+/// skipped without being decoded. Missing parameters keep the field's default, the last occurrence of a repeated
+/// parameter wins.
+/// @param query std::string or std::pmr::string
+template <typename pack_t, typename string_t>
+query_parse_result parse_query(string_t& query, pack_t& params) {
+    static constexpr auto labels = datalib::field_labels<typename pack_t::tuple_type_t>::value;
+    static constexpr perfect_hash<labels.size()> fields_by_label { labels };
+    /* an escaped name longer than this decodes into something longer than any label */
+    static constexpr std::size_t max_escaped_name_size = 3 * [] {
+        std::size_t size = 0;
+        for (const auto label : labels) {
+            size = std::max(size, label.size());
+        }
+        return size;
+    }();
+
+    query_parse_result result { };
+    char* position = query.data();
+    char* const end = position + query.size();
+
+    while (position != end and result.ok) {
+        auto* pair_end = std::find(position, end, '&');
+        auto* equals = std::find(position, pair_end, '=');
+
+        std::string_view name { position, static_cast<std::size_t>(equals - position) };
+        std::array<char, max_escaped_name_size> decoded_name;
+        if (name.find_first_of("%+") != std::string_view::npos) {
+            if (name.size() <= decoded_name.size()) {
+                std::copy(name.begin(), name.end(), decoded_name.begin());
+                name = { decoded_name.data(), percent_decode(decoded_name.data(), name.size()) };
+            } else {
+                name = { };
+            }
+        }
+        const auto index = name.empty() ? fields_by_label.npos : fields_by_label.find(name);
+
+        if (index != fields_by_label.npos) {
+            std::string_view value { };
+            if (equals != pair_end) {
+                value = { equals + 1, percent_decode(equals + 1, static_cast<std::size_t>(pair_end - equals - 1)) };
+            }
+
+            std::apply([&](auto&... fields) {
+                std::size_t i = 0;
+                if (not ((i++ != index or detail::parse_query_value(value, fields.value)) and ...)) {
+                    result = { false, labels[index] };
+                }
+            }, params.fields);
+        }
+
+        position = pair_end == end ? end : pair_end + 1;
+    }
+
+    return result;
+}
+
+} // namespace fhttp
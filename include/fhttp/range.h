@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace fhttp {
+
+/// @brief Resolved byte range of a representation
+struct byte_range {
+    std::size_t offset;
+    std::size_t length;
+};
+
+enum class range_status {
+    /// Range header is missing or malformed, it's ignored and the whole representation is sent
+    none,
+    satisfiable,
+    /// None of the ranges overlaps the representation, 416 should be sent
+    unsatisfiable
+};
+
+struct range_request {
+    range_status status { range_status::none };
+    std::vector<byte_range> ranges { };
+};
+
+/// @brief Parses value of a `Range` header (e.g. "bytes=0-99, 200-, -50") against a representation
+/// of `size` bytes, requests with more than `max_ranges` ranges are ignored (served whole)
+range_request parse_range(std::string_view header, std::size_t size, std::size_t max_ranges = 16);
+
+} // namespace fhttp
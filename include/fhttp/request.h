@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <boost/asio.hpp>
@@ -10,8 +13,17 @@
 #include <boost/regex.hpp>
 
 #include "meta.h"
+#include "body_format.h"
 #include "cookies.h"
+#include "header_map.h"
+#include "path_pattern.h"
+#include "query.h"
+#include "streaming_body.h"
+#include "data/cbor.h"
+#include "data/fieldset.h"
 #include "data/json.h"
+#include "data/json_reader.h"
+#include "data/msgpack.h"
 
 namespace fhttp {
 
@@ -45,6 +57,62 @@ std::string get_content_type(const T&) {
 }
 
 
+inline void write_body(std::string& out, const json<std::string>& value) {
+    out.append(value.data);
+}
+
+template <typename T>
+inline void write_body(std::string& out, const json<T>& value) {
+    datalib::serialization::write_json(out, value.data);
+}
+
+/// @brief Whether the format of a body of this type is negotiated (Content-Type, Accept), `json<std::string>` is
+/// JSON text that's passed through as it is
+template <typename body_t>
+inline constexpr bool has_body_format = is_specialization<body_t, json>::value and not std::is_same_v<body_t, json<std::string>>;
+
+template <typename T>
+    requires has_body_format<json<T>>
+inline void write_body(std::string& out, const json<T>& value, body_format format) {
+    switch (format) {
+    case body_format::json:
+        datalib::serialization::write_json(out, value.data);
+        break;
+    case body_format::msgpack:
+        datalib::serialization::write_msgpack(out, value.data);
+        break;
+    case body_format::cbor:
+        datalib::serialization::write_cbor(out, value.data);
+        break;
+    }
+}
+
+/// @brief Whether `json<T>` bodies can be narrowed down to a sparse fieldset (`?fields=`), T nests a data_pack
+template <typename body_t>
+inline constexpr bool has_fieldset = [] {
+    if constexpr (has_body_format<body_t>) {
+        return not std::is_void_v<typename datalib::detail::nested_pack<typename body_t::inner_t>::type>;
+    } else {
+        return false;
+    }
+}();
+
+template <typename T>
+    requires has_fieldset<json<T>>
+inline void write_body(std::string& out, const json<T>& value, body_format format, const datalib::fieldset<T>& fields) {
+    switch (format) {
+    case body_format::json:
+        datalib::serialization::write_json(out, value.data, fields);
+        break;
+    case body_format::msgpack:
+        datalib::serialization::write_msgpack(out, value.data, fields);
+        break;
+    case body_format::cbor:
+        datalib::serialization::write_cbor(out, value.data, fields);
+        break;
+    }
+}
+
 inline std::ostream& operator<<(std::ostream& os, const json<std::string>& json) {
     os << json.data;
     return os;
@@ -52,9 +120,9 @@ inline std::ostream& operator<<(std::ostream& os, const json<std::string>& json)
 
 template <typename T>
 inline std::ostream& operator<<(std::ostream& os, const json<T>& value) {
-    if (const auto serialized = datalib::serialization::to_json(value.data); serialized) {
-        os << boost::json::serialize(*serialized);
-    }
+    std::string serialized { };
+    datalib::serialization::write_json(serialized, value.data);
+    os << serialized;
     return os;
 }
 
@@ -74,45 +142,125 @@ enum class method {
 
 const char* method_to_string(method method);
 
-std::optional<method> string_to_method(const std::string& str);
+std::optional<method> string_to_method(std::string_view str);
 
-template <typename body_t, typename query_params_t = void>
+/// @brief Type of request::query_params of requests without typed query parameters
+struct no_query_params { };
+
+/// @brief HTTP request, `request<std::string>` is the one the parser fills, it owns all of its data. Typed requests
+/// made from it for handlers (convert_request) only view its path, query & headers, the body is moved into them.
+/// @tparam query_params_t data_pack filled from the query string (field labels are parameter names)
+/// @tparam path_params_t `path_params`, or a data_pack filled from parameters of the route's path pattern
+template <typename body_t, typename query_params_t = void, typename path_params_t = path_params>
 struct request {
     using body_type = body_t;
     using query_params_type = query_params_t;
+    using path_params_type = path_params_t;
+
+    static constexpr bool is_owning = std::is_same_v<body_t, std::string> and std::is_void_v<query_params_t> and std::is_same_v<path_params_t, path_params>;
+    using string_type = std::conditional_t<is_owning, std::string, std::string_view>;
 
     method method{};
-    std::string path{};
-    std::string version{};
+    string_type path{};
+    /// Query string, without the '?', as it was received (typed query_params are decoded from a copy)
+    string_type query{};
+    string_type version{};
     int http_version_major;
     int http_version_minor;
-    std::unordered_map<std::string, std::string> headers{};
+    basic_header_map<string_type> headers{};
     body_t body{};
     boost::asio::ip::tcp::endpoint remote_endpoint{};
-    cookies cookies{};
     boost::smatch url_matches{};
+    /// Parameters of a pattern route ("/users/{id:int}"), views of `path` of the request the route matched
+    path_params_t path_params{};
+    std::conditional_t<is_query_params_v<query_params_t>, query_params_t, no_query_params> query_params{};
+
+    /// Set when the matched route consumes the body as a stream, parser then writes the body here instead of `body`
+    streaming_body body_stream{};
+
+    /// Index of the route the router matched when the headers got parsed (requests with a body), it's not matched again
+    std::optional<std::size_t> matched_route{};
+
+    /// Scratch memory for the request (`std::pmr` containers), released in one step once its response is written
+    std::pmr::memory_resource* arena { std::pmr::get_default_resource() };
+
+    /// @brief Cookies, the Cookie header is scanned only on access (it has to be among the handler's request_headers)
+    fhttp::cookies cookies() const {
+        return fhttp::cookies { headers.get(known_header::cookie).value_or(std::string_view { }) };
+    }
+
+    /// @brief Untyped query parameters, scanned on access
+    url_encoded_fields query_fields() const {
+        return url_encoded_fields { query };
+    }
+
+    /// @brief Fields of an application/x-www-form-urlencoded body, scanned on access
+    url_encoded_fields form_fields() const requires std::is_same_v<body_t, std::string> {
+        return url_encoded_fields { body };
+    }
 };
 
+/// @brief Decodes a request body into `content`, the error code tells why it couldn't be
+/// @param format encoding of the body, only `json<T>` bodies (has_body_format) are read as anything but JSON
+/// @param memory scratch memory of the decoder
 template <typename content_t>
-inline content_t from_string(const std::string& str) {
+inline boost::system::error_code from_string(std::string_view str, content_t& content, body_format format = body_format::json, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    using namespace fhttp::datalib::deserialization;
+
     if constexpr (std::is_same_v<content_t, std::string>) {
-        return str;
+        FHTTP_UNUSED(format);
+        FHTTP_UNUSED(memory);
+        content = str;
+        return { };
+    } else if constexpr (has_body_format<content_t>) {
+        switch (format) {
+        case body_format::msgpack:
+            return read_msgpack(str, content.data, memory);
+        case body_format::cbor:
+            return read_cbor(str, content.data, memory);
+        case body_format::json:
+            break;
+        }
+        return read_json(str, content.data, memory);
     } else {
-        boost::json::value jv = boost::json::parse(str);
-        return { *fhttp::datalib::deserialization::from_json<typename content_t::inner_t>(jv) };
+        FHTTP_UNUSED(format);
+        return read_json(str, content.data, memory);
     }
 }
 
-template <typename body_t, typename query_params_t = void>
-inline request<body_t, query_params_t> convert_request(const request<std::string>& req) {
-    request<body_t, query_params_t> new_req {};
+/// @brief Format of a request body by its Content-Type, JSON when the header is missing or names another type
+template <typename headers_t>
+inline body_format request_body_format(const headers_t& headers) {
+    const auto content_type = headers.get(known_header::content_type);
+    return content_type ? body_format_of(*content_type).value_or(body_format::json) : body_format::json;
+}
+
+/// @brief Typed request for a handler, it views path, query & headers of `req` (which has to outlive it) and
+/// takes its body over. Typed path & query parameters (data_pack) are filled by the route.
+/// @param body_error set when the body can't be decoded into `body_t`
+template <typename body_t, typename query_params_t = void, typename path_params_t = path_params>
+inline request<body_t, query_params_t, path_params_t> convert_request(request<std::string>& req, boost::system::error_code& body_error) {
+    request<body_t, query_params_t, path_params_t> new_req {};
     new_req.method = req.method;
     new_req.path = req.path;
+    new_req.query = req.query;
     new_req.version = req.version;
-    new_req.headers = req.headers;
-    new_req.body = from_string<body_t>(req.body);
-    new_req.cookies = req.cookies;
+    new_req.http_version_major = req.http_version_major;
+    new_req.http_version_minor = req.http_version_minor;
+    new_req.headers = header_view_map::view_of(req.headers);
+    if constexpr (std::is_same_v<body_t, streaming_body>) {
+        new_req.body = std::move(req.body_stream);
+    } else if constexpr (std::is_same_v<body_t, std::string>) {
+        new_req.body = std::move(req.body);
+    } else {
+        body_error = from_string(req.body, new_req.body, request_body_format(req.headers), req.arena);
+    }
+    new_req.remote_endpoint = req.remote_endpoint;
     new_req.url_matches = req.url_matches;
+    new_req.arena = req.arena;
+    if constexpr (std::is_same_v<path_params_t, path_params>) {
+        new_req.path_params = req.path_params;
+    }
     return new_req;
 }
 
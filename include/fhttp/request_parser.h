@@ -4,9 +4,17 @@
 #include <boost/tuple/tuple.hpp>
 
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <memory>
+#include <functional>
 
+#include "errors.h"
 #include "request.h"
+#include "request_view.h"
+#include "header_filter.h"
 
 
 namespace fhttp {
@@ -21,21 +29,81 @@ public:
   /// Reset to initial parser state.
   void reset();
 
+  /// Whether a part of a request has already been consumed.
+  bool is_in_progress() const { return state_ != method_start; }
+
+  /// Set handler that's called once the headers of a request with a body are
+  /// parsed, before any of the body is stored. It may set req.body_stream, the
+  /// body is then written into the stream instead of req.body.
+  void on_body_start(std::function<void(request<std::string>&)> handler);
+
+  /// Limit for a single chunk of a chunked (Transfer-Encoding) body, bigger chunk makes the request invalid.
+  void set_max_chunk_size(std::size_t size);
+
+  static constexpr std::size_t default_max_chunk_size = 16 * 1024 * 1024;
+
+  /// Limit for the whole body (Content-Length or sum of the chunks), bigger body makes the request invalid.
+  void set_max_body_size(std::size_t size);
+
+  static constexpr std::size_t default_max_body_size = std::size_t { 1024 } * 1024 * 1024;
+
+  /// Why the last parse() returned false.
+  request_error error() const { return error_; }
+
+  /// Only headers retained by the filter are stored into the request, nullptr keeps all of them.
+  /// The filter has to outlive the parser (it's usually a router's constexpr filter).
+  void set_header_filter(const header_filter* filter);
+
   /// Parse some data. The tribool return value is true when a complete request
   /// has been parsed, false if the data is invalid, indeterminate when more
   /// data is required. The InputIterator return value indicates how much of the
-  /// input has been consumed.
+  /// input has been consumed, parsing stops right after the first complete request,
+  /// so anything in [returned iterator, end) belongs to the next (pipelined) request.
   template <typename InputIterator>
   boost::tuple<boost::tribool, InputIterator> parse(request<std::string>& req,
       InputIterator begin, InputIterator end)
   {
     while (begin != end)
     {
+      /* Body (or chunk data) is not parsed, so it's handed over in blocks straight from the input rather than char by char */
+      if constexpr (std::contiguous_iterator<InputIterator>)
+      {
+        if (state_ == content || state_ == chunk_data)
+        {
+          const auto available = static_cast<std::size_t>(end - begin);
+          const auto remaining = state_ == content ? content_length_ - content_received_ : chunk_remaining_;
+          const auto n = std::min(available, remaining);
+          append_body(req, std::string_view(std::to_address(begin), n));
+          begin += n;
+
+          if (state_ == chunk_data) {
+            chunk_remaining_ -= n;
+            if (chunk_remaining_ == 0) {
+              state_ = chunk_data_cr;
+            }
+          } else if (content_received_ == content_length_) {
+            return boost::make_tuple(boost::tribool(true), begin);
+          }
+          continue;
+        }
+      }
+
+      /* Runs of plain bytes (method, uri, header name & value) are scanned for their delimiter 16/32 bytes
+         at a time and appended at once, only the delimiter itself goes through the state machine */
+      if constexpr (std::contiguous_iterator<InputIterator>)
+      {
+        if (state_ == method || state_ == uri || state_ == header_name || state_ == header_value)
+        {
+          const auto n = consume_run(req, std::to_address(begin), std::to_address(end));
+          begin += n;
+          if (n != 0) {
+            continue;
+          }
+        }
+      }
+
       boost::tribool result = consume(req, *begin++);
       if (result || !result) {
-        if (begin != end) {
-            std::cout << "got more data than needed!!!\n";
-        }
         return boost::make_tuple(result, begin);
       }
     }
@@ -43,10 +111,28 @@ public:
     return boost::make_tuple(result, begin);
   }
 
+  /// Parse a whole request from the start of the input into views of the input, without copying
+  /// anything. Returns the size of the request (head & body), or nothing when the input doesn't start
+  /// with a complete request that can be represented by views (incomplete, malformed, chunked, obsolete
+  /// line folding, body over `max_body_size`...), such input has to be parsed by parse() instead. Headers
+  /// the filter doesn't retain are skipped.
+  static std::optional<std::size_t> parse_view(request_view& req, std::string_view input, const header_filter* filter = nullptr,
+      std::size_t max_body_size = default_max_body_size);
+
 private:
   /// Handle the next character of input.
   boost::tribool consume(request<std::string>& req, char input);
 
+  /// Consume the longest prefix of [begin, end) that doesn't change the state (the
+  /// rest of a method, uri, header name or header value), returns its length.
+  std::size_t consume_run(request<std::string>& req, const char* begin, const char* end);
+
+  /// Move the query string (after '?') of a complete uri from req.path into req.query.
+  static void split_query(request<std::string>& req);
+
+  /// Store a piece of the body, either into the body stream or req.body.
+  void append_body(request<std::string>& req, std::string_view chunk);
+
   /// Check if a byte is an HTTP character.
   static bool is_char(int c);
 
@@ -59,6 +145,12 @@ private:
   /// Check if a byte is a digit.
   static bool is_digit(int c);
 
+  /// Value of a hex digit, -1 when the byte is not a hex digit.
+  static int hex_value(int c);
+
+  /// Check whether the request's body uses chunked transfer coding, and no other one.
+  static bool is_chunked(const request<std::string>& req);
+
   /// The current state of the parser.
   enum state
   {
@@ -83,9 +175,34 @@ private:
     expecting_newline_2,
     expecting_newline_3,
     content,
+    chunk_size_start,
+    chunk_size,
+    chunk_extension,
+    chunk_size_newline,
+    chunk_data,
+    chunk_data_cr,
+    chunk_data_newline,
+    chunk_trailer_start,
+    chunk_trailer,
+    chunk_trailer_newline,
+    chunk_end_newline,
   } state_;
   std::string last_header_name;
   std::string last_method;
+
+  std::size_t content_length_;
+  std::size_t content_received_;
+  std::size_t chunk_remaining_;
+  std::size_t max_chunk_size_;
+  std::size_t max_body_size_;
+  /// Index of the header whose value is being parsed.
+  std::size_t header_index_;
+  const header_filter* header_filter_;
+  request_error error_;
+
+  /// header_index_ of a header that's not stored.
+  static constexpr std::size_t skipped_header = static_cast<std::size_t>(-1);
+  std::function<void(request<std::string>&)> body_start_handler_;
 };
 
 } // namespace fhttp
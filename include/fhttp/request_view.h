@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <boost/regex.hpp>
+
+#include "request.h"
+#include "header_map.h"
+
+namespace fhttp {
+
+/// @brief Request whose method, path, headers and body are slices of the connection's read buffer, nothing
+/// is copied or allocated while parsing it. Slices are valid only until the handler returns, handler that
+/// needs to keep anything has to copy it (e.g. `to_request()`).
+/// Used for requests that arrived whole within a single read, others are parsed into a `request<std::string>`.
+struct request_view {
+    using body_type = std::string_view;
+    using query_params_type = void;
+    using path_params_type = fhttp::path_params;
+    method method{};
+    std::string_view path{};
+    /// Query string, without the '?'
+    std::string_view query{};
+    int http_version_major{};
+    int http_version_minor{};
+    header_view_map headers{};
+    std::string_view body{};
+    boost::cmatch url_matches{};
+    path_params path_params{};
+    /// Scratch memory for the request (`std::pmr` containers), released in one step once its response is written
+    std::pmr::memory_resource* arena { std::pmr::get_default_resource() };
+
+    /// @brief Value of the first header with the given (case-insensitive) name
+    std::optional<std::string_view> header(std::string_view name) const;
+
+    /// @brief Cookies, the Cookie header is scanned only on access
+    fhttp::cookies cookies() const;
+
+    /// @brief Untyped query parameters, scanned on access
+    url_encoded_fields query_fields() const { return url_encoded_fields { query }; }
+
+    /// @brief Fields of an application/x-www-form-urlencoded body, scanned on access
+    url_encoded_fields form_fields() const { return url_encoded_fields { body }; }
+
+    /// @brief Owning copy of the request
+    request<std::string> to_request() const;
+};
+
+/// @brief View of an owned request, valid as long as the request is
+request_view view_of(const request<std::string>& req);
+
+/// @brief Typed request made straight from a view, nothing is copied: path, query & headers stay views of the
+/// read buffer and the body is decoded from it (it can't be a streaming_body, that one needs the owned request)
+/// @param body_error set when the body can't be decoded into `body_t`
+template <typename body_t, typename query_params_t = void, typename path_params_t = path_params>
+inline request<body_t, query_params_t, path_params_t> convert_request(const request_view& req, boost::system::error_code& body_error) {
+    static_assert(not request<body_t, query_params_t, path_params_t>::is_owning, "owned request has to be made by to_request()");
+    static_assert(not std::is_same_v<body_t, streaming_body>, "streaming_body needs the owned request");
+
+    request<body_t, query_params_t, path_params_t> new_req {};
+    new_req.method = req.method;
+    new_req.path = req.path;
+    new_req.query = req.query;
+    new_req.http_version_major = req.http_version_major;
+    new_req.http_version_minor = req.http_version_minor;
+    new_req.headers = req.headers;
+    body_error = from_string(req.body, new_req.body, request_body_format(req.headers), req.arena);
+    new_req.arena = req.arena;
+    if constexpr (std::is_same_v<path_params_t, path_params>) {
+        new_req.path_params = req.path_params;
+    }
+    return new_req;
+}
+
+} // namespace fhttp
@@ -3,14 +3,57 @@
 #include <string>
 #include <unordered_map>
 #include <sstream>
+#include <iostream>
 #include <format>
+#include <charconv>
+#include <functional>
+#include <optional>
 
+#include <boost/asio.hpp>
 #include <boost/json.hpp>
 
+#include "body_format.h"
+#include "file_cache.h"
+#include "header_map.h"
+#include "meta.h"
+#include "status_codes.h"
+
 namespace fhttp {
 
 using json_response = boost::json::object;
 
+namespace detail {
+
+inline void append_number(std::string& out, std::size_t number) {
+    char digits[24];
+    const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), number);
+    out.append(digits, end);
+}
+
+inline void append_hex_number(std::string& out, std::size_t number) {
+    char digits[24];
+    const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), number, 16);
+    out.append(digits, end);
+}
+
+} // namespace detail
+
+/// @brief Response body type for bodies that are produced piece by piece, headers are sent as soon as the
+/// handler returns and the producer is then asked for the next piece every time the previous one got written
+/// to the socket (so a slow client slows the producer down instead of piling the body up in memory).
+/// Body is sent with `Transfer-Encoding: chunked`, or as is when `content_length` is known upfront.
+struct response_stream {
+    /// @brief Appends next piece of the body to `out` (which is empty), returns false once the body is complete
+    using producer_t = std::function<bool(std::string& out)>;
+
+    producer_t producer { };
+    std::optional<std::size_t> content_length { };
+
+    explicit operator bool() const {
+        return static_cast<bool>(producer);
+    }
+};
+
 template <typename body_t>
 struct response {
     using body_type = body_t;
@@ -18,7 +61,13 @@ struct response {
     int status_code{200};
     body_t body{};
     std::string version{"HTTP/1.1"};
-    std::unordered_map<std::string, std::string> headers{};
+    header_map headers{};
+
+    /// Set when the handler produces the body as a stream, `body` is then ignored
+    response_stream body_stream{};
+
+    /// Set when the body is made of (parts of) files, they are sent with sendfile and `body` is ignored
+    file_body body_file{};
 
     void send(boost::asio::ip::tcp::socket& socket) {
         std::stringstream ss {};
@@ -27,7 +76,7 @@ struct response {
         body_ss << body;
         std::string body = body_ss.str();
 
-        ss << "HTTP/1.1 " << std::to_string(status_code) << " OK\r\n";
+        ss << "HTTP/1.1 " << std::to_string(status_code) << ' ' << status_reason(status_code) << "\r\n";
         
         headers["Content-Length"] = std::to_string(body.size());
 
@@ -45,37 +94,110 @@ struct response {
     }
 
     std::string to_string() {
-        std::stringstream ss {};
-
         std::stringstream body_ss {};
         body_ss << body;
         std::string body = body_ss.str();
 
-        ss << "HTTP/1.1 " << std::to_string(status_code) << " OK\r\n";
-        
-        headers["Content-Length"] = std::to_string(body.size());
+        std::string out {};
+        serialize_head(out, body.size());
+        out.append(body);
+
+        return out;
+    }
+
+    /// @brief Appends status line and headers (with the given Content-Length) to `out`,
+    /// the body itself is not touched so it can be sent as a separate buffer (writev) 
+    /// @param out buffer that gets appended to, meant to be reused between responses
+    /// @param content_length size of the body that will follow the headers, body of unknown size is sent 
+    /// chunked (HTTP/1.1) or delimited by closing the connection (HTTP/1.0)
+    void serialize_head(std::string& out, std::optional<std::size_t> content_length) const {
+        out.append(version);
+        out.push_back(' ');
+        detail::append_number(out, status_code);
+        out.push_back(' ');
+        out.append(status_reason(status_code)).append("\r\n");
 
         for (const auto& [key, value] : headers) {
-            ss << key << ": " << value << "\r\n";
+            if (header_name_equals(key, HEADER_CONTENT_LENGTH) or header_name_equals(key, HEADER_TRANSFER_ENCODING)) {
+                continue;
+            }
+            out.append(key).append(": ").append(value).append("\r\n");
         }
 
-        ss << "\r\n";
-        ss << body; 
+        if (content_length) {
+            out.append("Content-Length: ");
+            detail::append_number(out, *content_length);
+            out.append("\r\n");
+        } else if (is_chunked()) {
+            out.append("Transfer-Encoding: chunked\r\n");
+        }
+        out.append("\r\n");
+    }
 
-        return ss.str();
+    /// @brief Whether the body of unknown length is going to be sent using chunked transfer coding
+    bool is_chunked() const {
+        return body_stream and not body_stream.content_length and version == "HTTP/1.1";
     }
 };
 
+/// @brief Serializes a typed body straight into `out`, the buffer that's then sent as the body of the response.
+/// Body types can provide their own `write_body` overload (found by ADL), the fallback is operator<<.
 template <typename body_t>
-inline response<std::string> convert_to_string_response(const response<body_t>& resp) {
-    response<std::string> new_resp {};
-    new_resp.status_code = resp.status_code;
-    std::stringstream ss_body {};
-    ss_body << resp.body;
-    new_resp.body = ss_body.str();
-    new_resp.version = resp.version;
-    new_resp.headers = resp.headers;
-    return new_resp;
+inline void write_body(std::string& out, const body_t& body) {
+    if constexpr (std::is_convertible_v<const body_t&, std::string_view>) {
+        out.append(std::string_view { body });
+    } else if constexpr (std::is_arithmetic_v<body_t>) {
+        char digits[32];
+        const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), body);
+        out.append(digits, end);
+    } else {
+        std::ostringstream ss { };
+        ss << body;
+        out.append(ss.view());
+    }
+}
+
+/// @brief Moves a typed response into the string response that's going to be sent: headers & file/stream bodies
+/// are moved, the body is serialized directly into `out.body`. Headers already set on `out` (by the server or a
+/// middleware) are kept unless the typed response sets the same header.
+/// @param format encoding negotiated for bodies that have one (`write_body(out, body, format)`, e.g. `json<T>`),
+/// formats other than JSON set their Content-Type, all of them add Accept to Vary (caches keep the formats apart)
+/// @param options further arguments of such write_body, e.g. the fieldset of a `json<T>` body
+template <typename body_t, typename... options_t>
+inline void write_response(response<body_t>&& typed, response<std::string>& out, body_format format = body_format::json, const options_t&... options) {
+    out.status_code = typed.status_code;
+    out.version = std::move(typed.version);
+
+    for (std::size_t i = 0; i < typed.headers.size(); ++i) {
+        auto& [name, value] = *(typed.headers.begin() + static_cast<std::ptrdiff_t>(i));
+        if (typed.headers.index_of(name) == i) {
+            out.headers[name] = std::move(value);
+        } else {
+            out.headers.append(std::move(name), std::move(value));
+        }
+    }
+
+    if constexpr (std::is_same_v<body_t, response_stream>) {
+        out.body_stream = std::move(typed.body);
+    } else if constexpr (std::is_same_v<body_t, std::string>) {
+        out.body = std::move(typed.body);
+    } else if constexpr (requires { write_body(out.body, typed.body, format, options...); }) {
+        write_body(out.body, typed.body, format, options...);
+        if (format != body_format::json) {
+            out.headers[HEADER_CONTENT_TYPE] = std::string { media_type_of(format) };
+        }
+        add_vary_accept(out.headers);
+    } else {
+        FHTTP_UNUSED(format);
+        (FHTTP_UNUSED(options), ...);
+        write_body(out.body, typed.body);
+    }
+    if (typed.body_stream) {
+        out.body_stream = std::move(typed.body_stream);
+    }
+    if (typed.body_file) {
+        out.body_file = std::move(typed.body_file);
+    }
 }
 
-}
\ No newline at end of file
+}
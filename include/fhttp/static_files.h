@@ -0,0 +1,108 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "meta.h"
+#include "request.h"
+#include "request_view.h"
+#include "response.h"
+#include "headers.h"
+#include "status_codes.h"
+#include "file_cache.h"
+#include "header_filter.h"
+
+namespace fhttp {
+
+/// @brief Fills the response with the file, honouring Range (single range, or multipart/byteranges
+/// for several) and If-Range headers, ranges are sent with sendfile same as the whole file
+void serve_file(std::optional<std::string_view> range_header, std::optional<std::string_view> if_range, response<std::string>& resp, std::shared_ptr<const cached_file> file);
+
+/// @brief Only used to describe static_files_route in the generated OpenAPI spec
+struct static_files_description {
+    static constexpr const char* description = "Static files";
+
+    void handle(const request<std::string>&, response<std::string>&) { }
+};
+
+/// @brief Route serving files from a directory, files are kept open in a file_cache and their
+/// content is sent with sendfile straight from the page cache, never touching user space memory
+/// @tparam prefix URL prefix, e.g. "/static/", rest of the path is a path relative to the directory
+/// @tparam root_directory pointer to the config member with the directory, e.g. &server_config::static_files_path
+template <label_literal prefix, auto root_directory>
+struct static_files_route {
+    using handler_type = static_files_description;
+    static constexpr const char* path_value = prefix.c_str();
+    static constexpr method method_value = method::get;
+    static constexpr header_filter request_header_filter = header_filter::of({ HEADER_RANGE, HEADER_IF_RANGE });
+
+    template <typename global_data_t, typename config_t>
+    static bool handle_request(request<std::string>& req, response<std::string>& resp, global_data_t&, const config_t& config) {
+        return serve(req.path, req.method, req.headers.get(known_header::range), req.headers.get(known_header::if_range), resp, config);
+    }
+
+    template <typename global_data_t, typename config_t>
+    static bool handle_view(request_view& req, response<std::string>& resp, global_data_t&, const config_t& config, std::size_t) {
+        return serve(req.path, req.method, req.headers.get(known_header::range), req.headers.get(known_header::if_range), resp, config);
+    }
+
+    template <typename global_data_t, typename config_t>
+    static bool prepare_body(request<std::string>& req, global_data_t&, const config_t&, std::size_t) {
+        return matches(req.path, req.method).has_value();
+    }
+
+    static bool matches_path(std::string_view path) {
+        return path.starts_with(prefix.c_str());
+    }
+
+private:
+    template <typename config_t>
+    static bool serve(
+        std::string_view path,
+        method method,
+        std::optional<std::string_view> range,
+        std::optional<std::string_view> if_range,
+        response<std::string>& resp,
+        const config_t& config
+    ) {
+        const auto relative_path = matches(path, method);
+        if (not relative_path) {
+            return false;
+        }
+
+        if (not is_safe_path(*relative_path)) {
+            resp.status_code = STATUS_CODE_FORBIDDEN;
+            return true;
+        }
+
+        const std::string& root = config.*root_directory;
+        auto file = cache().get(root + std::string { *relative_path });
+
+        if (not file) {
+            resp.status_code = STATUS_CODE_NOT_FOUND;
+            return true;
+        }
+
+        serve_file(range, if_range, resp, std::move(file));
+        return true;
+    }
+
+    static std::optional<std::string_view> matches(std::string_view path, method method) {
+        if (method != method_value or not path.starts_with(prefix.c_str())) {
+            return std::nullopt;
+        }
+        return path.substr(std::string_view { prefix.c_str() }.size());
+    }
+
+    static bool is_safe_path(std::string_view path) {
+        return path.find("..") == std::string_view::npos and path.find('\0') == std::string_view::npos;
+    }
+
+    static file_cache& cache() {
+        static file_cache instance { };
+        return instance;
+    }
+};
+
+} // namespace fhttp
@@ -1,13 +1,17 @@
 #pragma once
 
+#include <string_view>
+
 namespace fhttp {
     // Status codes
     inline constexpr int STATUS_CODE_OK = 200;
     inline constexpr int STATUS_CODE_CREATED = 201;
     inline constexpr int STATUS_CODE_ACCEPTED = 202;    
     inline constexpr int STATUS_CODE_NO_CONTENT = 204;
+    inline constexpr int STATUS_CODE_PARTIAL_CONTENT = 206;
     inline constexpr int STATUS_CODE_MOVED_PERMANENTLY = 301;
     inline constexpr int STATUS_CODE_FOUND = 302;
+    inline constexpr int STATUS_CODE_NOT_MODIFIED = 304;
     inline constexpr int STATUS_CODE_BAD_REQUEST = 400;
     inline constexpr int STATUS_CODE_UNAUTHORIZED = 401;
     inline constexpr int STATUS_CODE_FORBIDDEN = 403;
@@ -23,6 +27,7 @@ namespace fhttp {
     inline constexpr int STATUS_CODE_PRECONDITION_FAILED = 412;
     inline constexpr int STATUS_CODE_PAYLOAD_TOO_LARGE = 413;
     inline constexpr int STATUS_CODE_UNSUPPORTED_MEDIA_TYPE = 415;
+    inline constexpr int STATUS_CODE_RANGE_NOT_SATISFIABLE = 416;
     inline constexpr int STATUS_CODE_EXPECTATION_FAILED = 417;
     inline constexpr int STATUS_CODE_UPGRADE_REQUIRED = 426;
     inline constexpr int STATUS_CODE_PRECONDITION_REQUIRED = 428;
@@ -30,4 +35,42 @@ namespace fhttp {
     inline constexpr int STATUS_CODE_UNPROCESSABLE_ENTITY = 422;
     inline constexpr int STATUS_CODE_LOCKED = 423;
     inline constexpr int STATUS_CODE_FAILED_DEPENDENCY = 424;
-}
\ No newline at end of file
+
+    /// @brief Reason phrase of the status line
+    constexpr std::string_view status_reason(int status_code) {
+        switch (status_code) {
+        case STATUS_CODE_OK: return "OK";
+        case STATUS_CODE_CREATED: return "Created";
+        case STATUS_CODE_ACCEPTED: return "Accepted";
+        case STATUS_CODE_NO_CONTENT: return "No Content";
+        case STATUS_CODE_PARTIAL_CONTENT: return "Partial Content";
+        case STATUS_CODE_MOVED_PERMANENTLY: return "Moved Permanently";
+        case STATUS_CODE_FOUND: return "Found";
+        case STATUS_CODE_NOT_MODIFIED: return "Not Modified";
+        case STATUS_CODE_BAD_REQUEST: return "Bad Request";
+        case STATUS_CODE_UNAUTHORIZED: return "Unauthorized";
+        case STATUS_CODE_FORBIDDEN: return "Forbidden";
+        case STATUS_CODE_NOT_FOUND: return "Not Found";
+        case STATUS_CODE_METHOD_NOT_ALLOWED: return "Method Not Allowed";
+        case STATUS_CODE_REQUEST_TIMEOUT: return "Request Timeout";
+        case STATUS_CODE_CONFLICT: return "Conflict";
+        case STATUS_CODE_PRECONDITION_FAILED: return "Precondition Failed";
+        case STATUS_CODE_PAYLOAD_TOO_LARGE: return "Payload Too Large";
+        case STATUS_CODE_UNSUPPORTED_MEDIA_TYPE: return "Unsupported Media Type";
+        case STATUS_CODE_RANGE_NOT_SATISFIABLE: return "Range Not Satisfiable";
+        case STATUS_CODE_EXPECTATION_FAILED: return "Expectation Failed";
+        case STATUS_CODE_UNPROCESSABLE_ENTITY: return "Unprocessable Entity";
+        case STATUS_CODE_LOCKED: return "Locked";
+        case STATUS_CODE_FAILED_DEPENDENCY: return "Failed Dependency";
+        case STATUS_CODE_TOO_EARLY: return "Too Early";
+        case STATUS_CODE_UPGRADE_REQUIRED: return "Upgrade Required";
+        case STATUS_CODE_PRECONDITION_REQUIRED: return "Precondition Required";
+        case STATUS_CODE_TOO_MANY_REQUESTS: return "Too Many Requests";
+        case STATUS_CODE_INTERNAL_SERVER_ERROR: return "Internal Server Error";
+        case STATUS_CODE_NOT_IMPLEMENTED: return "Not Implemented";
+        case STATUS_CODE_SERVICE_UNAVAILABLE: return "Service Unavailable";
+        case STATUS_CODE_HTTP_VERSION_NOT_SUPPORTED: return "HTTP Version Not Supported";
+        default: return "Unknown";
+        }
+    }
+}
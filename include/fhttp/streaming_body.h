@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace fhttp {
+
+/// @brief Request body type for handlers that don't want the whole body buffered in memory
+///
+/// Body is either handed to the chunk handler installed by the handler's `prepare_body` as it comes
+/// off the socket (next read is issued only after the chunk handler returns, so a slow consumer pauses
+/// reading from the client), or it's buffered in memory until `spill_threshold` bytes and in an anonymous
+/// temporary file from then on. Memory used by the upload is bounded by the threshold/read buffer size.
+///
+/// It's a cheap handle, copies refer to the same body.
+struct streaming_body {
+    using chunk_handler_t = std::function<void(std::string_view)>;
+
+    static constexpr std::size_t default_spill_threshold = 1024 * 1024;
+
+    streaming_body() = default;
+    explicit streaming_body(std::size_t spill_threshold);
+
+    /// @brief Installs handler that receives body chunks as they arrive, nothing gets buffered afterwards
+    void on_chunk(chunk_handler_t handler);
+
+    /// @brief Appends a chunk of the body (used by the request parser)
+    void write(std::string_view chunk);
+
+    /// @brief Number of body bytes received so far
+    std::size_t size() const;
+
+    /// @brief Whether body got too big and was moved to a temporary file
+    bool is_spilled() const;
+
+    /// @brief Whether writing the body to its temporary file failed (e.g. full disk), the body is lost then.
+    /// Such requests are answered with 500 before their handler runs.
+    bool is_failed() const;
+
+    /// @brief Reads the buffered body (from memory or the temporary file) chunk by chunk
+    /// @return false if the body couldn't be stored or reading the temporary file failed
+    bool read(const chunk_handler_t& handler) const;
+
+    /// @brief Reads whole buffered body into a string, meant for small bodies only, empty if the body was lost
+    std::string to_string() const;
+
+    explicit operator bool() const {
+        return state != nullptr;
+    }
+
+private:
+    struct file_closer {
+        void operator()(std::FILE* file) const {
+            std::fclose(file);
+        }
+    };
+
+    struct body_state {
+        std::size_t spill_threshold { default_spill_threshold };
+        std::size_t size { 0 };
+        std::string memory { };
+        std::unique_ptr<std::FILE, file_closer> spill_file { };
+        chunk_handler_t chunk_handler { };
+        bool is_failed { false };
+    };
+
+    /* drops what was stored of the body, which can't be completed anymore */
+    void fail();
+
+    std::shared_ptr<body_state> state { };
+};
+
+} // namespace fhttp
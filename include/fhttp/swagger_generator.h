@@ -87,6 +87,50 @@ inline void generate_content_definition(boost::json::object&, const request_t&)
     FHTTP_LOG(INFO) << "Generating request body definition for unknown type" << typeid(request_t).name();
 }
 
+template <typename route_t>
+constexpr bool is_pattern_route() {
+    if constexpr (requires { route_t::is_pattern; }) {
+        return route_t::is_pattern;
+    } else {
+        return false;
+    }
+}
+
+template <typename field_t>
+boost::json::object generate_query_parameter(const field_t&) {
+    boost::json::object parameter;
+    parameter["name"] = field_t::label;
+    parameter["in"] = "query";
+    parameter["required"] = false;
+    parameter["schema"] = {{ "type", field_t::field_type_name() }};
+    if (std::string_view { field_t::description }.size() > 0) {
+        parameter["description"] = field_t::description;
+    }
+    return parameter;
+}
+
+/// @brief Lists the body under every media type it can be sent in, `json<T>` bodies are negotiated (body_format.h)
+template <typename body_t>
+void add_media_types(boost::json::object& content, const boost::json::object& media_type) {
+    if constexpr (has_body_format<body_t>) {
+        for (const auto name : body_format_media_types) {
+            content[name] = media_type;
+        }
+    } else {
+        content["application/json"] = media_type;
+    }
+}
+
+/// @brief Path of the route in the spec, patterns are written without parameter types ("/users/{id}")
+template <typename route_t>
+std::string openapi_path() {
+    if constexpr (is_pattern_route<route_t>()) {
+        return route_t::pattern_type::openapi_path();
+    } else {
+        return route_t::path_value;
+    }
+}
+
 template <typename view_t>
 boost::json::value generateV3(
     const std::string& app_title,
@@ -114,7 +158,8 @@ boost::json::value generateV3(
     /// Iterate over the routes
     std::apply([&paths](auto&& ... routes) {
         (..., [&paths](auto&& route) {
-            const std::string path = route.path_value;
+            using route_t = std::decay_t<decltype(route)>;
+            const std::string path = openapi_path<route_t>();
 
             const auto create_node = [&] (boost::json::object& path_object) {
 
@@ -125,6 +170,36 @@ boost::json::value generateV3(
 
                 const auto generate_parameters = []() {
                     boost::json::array parameters;
+                    if constexpr (is_pattern_route<route_t>()) {
+                        for (const auto& segment : route_t::pattern_type::segments) {
+                            if (not segment.is_parameter) {
+                                continue;
+                            }
+                            boost::json::object parameter;
+                            parameter["name"] = segment.text;
+                            parameter["in"] = "path";
+                            parameter["required"] = true;
+                            parameter["schema"] = {{ "type", segment.type == path_param_type::integer ? "integer" : "string" }};
+                            parameters.push_back(std::move(parameter));
+                        }
+                    }
+
+                    using query_params_t = typename request_t::query_params_type;
+                    if constexpr (is_query_params_v<query_params_t>) {
+                        std::apply([&parameters](const auto&... fields) {
+                            (parameters.push_back(generate_query_parameter(fields)), ...);
+                        }, typename query_params_t::tuple_type_t { });
+                    }
+
+                    if constexpr (has_fieldset<typename response_t::body_type>) {
+                        boost::json::object parameter;
+                        parameter["name"] = fields_query_parameter;
+                        parameter["in"] = "query";
+                        parameter["required"] = false;
+                        parameter["schema"] = {{ "type", "string" }};
+                        parameter["description"] = "Comma separated fields of the response to return, nested ones as e.g. `profiles.name`";
+                        parameters.push_back(std::move(parameter));
+                    }
                     return parameters;
                 };
 
@@ -142,7 +217,7 @@ boost::json::value generateV3(
                     generate_content_definition(schema, response_t_instance);
 
                     request_type["schema"] = schema;
-                    content["application/json"] = request_type;
+                    add_media_types<typename response_t::body_type>(content, request_type);
                     response_body["content"] = content;
                     responses["200"] = response_body;
 
@@ -164,7 +239,7 @@ boost::json::value generateV3(
                     generate_content_definition(schema, request_t_instance);
 
                     request_type["schema"] = schema;
-                    content["application/json"] = request_type;
+                    add_media_types<typename request_t::body_type>(content, request_type);
                     request_body["content"] = content;
                     
                     node["requestBody"] = request_body;
@@ -0,0 +1,37 @@
+#include <fhttp/arena.h>
+
+#include <memory>
+
+namespace fhttp {
+
+request_arena::request_arena(std::size_t block_size)
+    : block_size { block_size }
+{ }
+
+void* request_arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    used_bytes += bytes;
+
+    /* block is leased only once something is allocated, idle connections don't hold one */
+    if (block.empty()) {
+        block = buffer_pool::local().lease(block_size);
+        block_used = 0;
+    }
+
+    void* position = block.data() + block_used;
+    std::size_t space = block.size() - block_used;
+    if (std::align(alignment, bytes, position, space)) {
+        block_used = block.size() - space + bytes;
+        return position;
+    }
+
+    return overflow.allocate(bytes, alignment);
+}
+
+void request_arena::release() {
+    block.release();
+    block_used = 0;
+    used_bytes = 0;
+    overflow.release();
+}
+
+} // namespace fhttp
@@ -0,0 +1,113 @@
+#include <fhttp/body_format.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "text.h"
+
+namespace fhttp {
+
+using detail::trim;
+
+namespace {
+
+/* media type of a Content-Type or an Accept entry, without parameters */
+std::string_view media_type(std::string_view value) {
+    return trim(value.substr(0, value.find(';')));
+}
+
+/* q-value of an Accept entry in thousandths, 1000 when it has none */
+int quality_of(std::string_view entry) {
+    auto parameters = entry.substr(std::min(entry.find(';'), entry.size()));
+    while (not parameters.empty()) {
+        parameters.remove_prefix(1);
+        const auto parameter = trim(parameters.substr(0, parameters.find(';')));
+        parameters.remove_prefix(std::min(parameters.find(';'), parameters.size()));
+
+        if (parameter.size() < 2 or (parameter[0] != 'q' and parameter[0] != 'Q') or parameter[1] != '=') {
+            continue;
+        }
+
+        /* "0.5" -> 500, at most three decimals are allowed */
+        const auto value = parameter.substr(2);
+        int quality = 0;
+        const auto [integer_end, ec] = std::from_chars(value.data(), value.data() + value.size(), quality);
+        if (ec != std::errc { } or quality > 1) {
+            return 0;
+        }
+        quality *= 1000;
+        if (integer_end != value.data() + value.size() and *integer_end == '.') {
+            int scale = 100;
+            for (const char* digit = integer_end + 1; digit != value.data() + value.size() and scale > 0; ++digit, scale /= 10) {
+                if (*digit < '0' or *digit > '9') {
+                    break;
+                }
+                quality += (*digit - '0') * scale;
+            }
+        }
+        return std::min(quality, 1000);
+    }
+    return 1000;
+}
+
+} // namespace
+
+std::optional<body_format> body_format_of(std::string_view content_type) {
+    const auto type = media_type(content_type);
+    if (header_name_equals(type, MEDIA_TYPE_JSON)) {
+        return body_format::json;
+    }
+    if (header_name_equals(type, MEDIA_TYPE_MSGPACK) or header_name_equals(type, "application/x-msgpack")
+        or header_name_equals(type, "application/vnd.msgpack")) {
+        return body_format::msgpack;
+    }
+    if (header_name_equals(type, MEDIA_TYPE_CBOR)) {
+        return body_format::cbor;
+    }
+    return std::nullopt;
+}
+
+body_format accepted_body_format(std::optional<std::string_view> accept) {
+    if (not accept) {
+        return body_format::json;
+    }
+
+    auto best = body_format::json;
+    int best_quality = 0;
+    std::string_view entries = *accept;
+    while (not entries.empty()) {
+        const auto comma = entries.find(',');
+        const auto entry = entries.substr(0, comma);
+        entries.remove_prefix(comma == std::string_view::npos ? entries.size() : comma + 1);
+
+        const auto type = media_type(entry);
+        auto format = body_format_of(type);
+        if (not format and (type == "*/*" or header_name_equals(type, "application/*"))) {
+            format = body_format::json;
+        }
+
+        if (format) {
+            const auto quality = quality_of(entry);
+            if (quality > best_quality) {
+                best = *format;
+                best_quality = quality;
+            }
+        }
+    }
+    return best;
+}
+
+void add_vary_accept(header_map& headers) {
+    auto& vary = headers[HEADER_VARY];
+    for (std::string_view rest = vary; not rest.empty(); ) {
+        const auto comma = std::min(rest.find(','), rest.size());
+        const auto name = trim(rest.substr(0, comma));
+        if (name == "*" or header_name_equals(name, HEADER_ACCEPT)) {
+            return;
+        }
+        rest.remove_prefix(std::min(comma + 1, rest.size()));
+    }
+    vary.append(vary.empty() ? "" : ", ").append(HEADER_ACCEPT);
+}
+
+} // namespace fhttp
@@ -0,0 +1,70 @@
+#include <fhttp/buffer_pool.h>
+
+#include <algorithm>
+#include <utility>
+#include <bit>
+
+namespace fhttp {
+
+leased_buffer::leased_buffer(std::unique_ptr<char[]>&& data, std::size_t size)
+    : storage { std::move(data) }
+    , capacity { size }
+{ }
+
+leased_buffer::leased_buffer(leased_buffer&& other) noexcept
+    : storage { std::move(other.storage) }
+    , capacity { std::exchange(other.capacity, 0) }
+{ }
+
+leased_buffer& leased_buffer::operator=(leased_buffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        storage = std::move(other.storage);
+        capacity = std::exchange(other.capacity, 0);
+    }
+    return *this;
+}
+
+leased_buffer::~leased_buffer() {
+    release();
+}
+
+void leased_buffer::release() {
+    if (storage) {
+        buffer_pool::local().give_back(std::move(storage), capacity);
+        capacity = 0;
+    }
+}
+
+buffer_pool& buffer_pool::local() {
+    thread_local buffer_pool pool { };
+    return pool;
+}
+
+std::size_t buffer_pool::size_class(std::size_t size) {
+    size = std::clamp(size, min_buffer_size, max_buffer_size);
+    return std::bit_width(std::bit_ceil(size) / min_buffer_size) - 1;
+}
+
+leased_buffer buffer_pool::lease(std::size_t size) {
+    const auto index = size_class(size);
+    const auto class_size = min_buffer_size << index;
+
+    auto& buffers = free_buffers[index];
+    if (buffers.empty()) {
+        return { std::make_unique_for_overwrite<char[]>(class_size), class_size };
+    }
+
+    auto data = std::move(buffers.back());
+    buffers.pop_back();
+    return { std::move(data), class_size };
+}
+
+void buffer_pool::give_back(std::unique_ptr<char[]>&& data, std::size_t size) {
+    auto& buffers = free_buffers[size_class(size)];
+    if (buffers.size() < max_buffers_per_class) {
+        buffers.push_back(std::move(data));
+    }
+}
+
+} // namespace fhttp
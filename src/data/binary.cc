@@ -0,0 +1,101 @@
+#include <fhttp/data/binary.h>
+
+#include <array>
+
+namespace fhttp {
+namespace datalib {
+namespace deserialization {
+namespace detail {
+
+boost::system::error_code read_binary(std::string_view input, json_sink root, std::pmr::memory_resource* memory, binary_token_decoder decoder) {
+    /* containers that are still being read, with the number of items they are missing */
+    struct container {
+        std::uint64_t remaining;
+        bool is_map;
+        bool expects_key;
+    };
+    static constexpr std::size_t max_depth = 64;
+    std::array<container, max_depth> stack;
+    std::size_t depth = 0;
+
+    reader_handler handler { root, memory };
+    boost::system::error_code ec;
+    const char* position = input.data();
+    const char* const end = position + input.size();
+
+    handler.on_document_begin(ec);
+    do {
+        binary_token token { };
+        if (not decoder(position, end, token)) {
+            return make_error_code(json_read_error::invalid_encoding);
+        }
+
+        if (depth > 0 and stack[depth - 1].is_map and stack[depth - 1].expects_key) {
+            if (token.type != binary_token::kind::string) {
+                return make_error_code(json_read_error::invalid_encoding);
+            }
+            if (not handler.on_key({ token.string.data(), token.string.size() }, token.string.size(), ec)) {
+                return ec;
+            }
+            stack[depth - 1].expects_key = false;
+            continue;
+        }
+
+        bool ok = true;
+        bool is_complete = true;
+        switch (token.type) {
+        case binary_token::kind::null: ok = handler.on_null(ec); break;
+        case binary_token::kind::boolean: ok = handler.on_bool(token.boolean, ec); break;
+        case binary_token::kind::int64: ok = handler.on_int64(token.int64, { }, ec); break;
+        case binary_token::kind::uint64: ok = handler.on_uint64(token.uint64, { }, ec); break;
+        case binary_token::kind::float64: ok = handler.on_double(token.float64, { }, ec); break;
+        case binary_token::kind::string:
+            ok = handler.on_string({ token.string.data(), token.string.size() }, token.string.size(), ec);
+            break;
+        case binary_token::kind::array:
+        case binary_token::kind::map: {
+            const bool is_map = token.type == binary_token::kind::map;
+            ok = is_map ? handler.on_object_begin(ec) : handler.on_array_begin(ec);
+            if (not ok) {
+                break;
+            }
+            if (token.uint64 == 0) {
+                ok = is_map ? handler.on_object_end(0, ec) : handler.on_array_end(0, ec);
+            } else if (depth == max_depth) {
+                return make_error_code(json_read_error::too_deep);
+            } else {
+                stack[depth++] = { token.uint64, is_map, is_map };
+                is_complete = false;
+            }
+            break;
+        }
+        }
+        if (not ok) {
+            return ec;
+        }
+
+        /* completed value may be the last item of its container(s) */
+        while (is_complete and depth > 0) {
+            auto& top = stack[depth - 1];
+            top.expects_key = top.is_map;
+            if (--top.remaining != 0) {
+                break;
+            }
+            --depth;
+            if (not (top.is_map ? handler.on_object_end(0, ec) : handler.on_array_end(0, ec))) {
+                return ec;
+            }
+        }
+    } while (depth > 0);
+
+    if (position != end) {
+        return boost::json::error::extra_data;
+    }
+    handler.on_document_end(ec);
+    return ec;
+}
+
+} // namespace detail
+} // namespace deserialization
+} // namespace datalib
+} // namespace fhttp
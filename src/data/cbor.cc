@@ -0,0 +1,228 @@
+#include <fhttp/data/cbor.h>
+
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace fhttp {
+namespace datalib {
+
+namespace {
+
+using detail::append_big_endian;
+using detail::read_big_endian;
+
+/* initial byte of the major type & the argument in its smallest representation */
+void write_head(std::string& out, unsigned major, std::uint64_t argument) {
+    const auto type = static_cast<unsigned char>(major << 5);
+    if (argument < 24) {
+        out.push_back(static_cast<char>(type | argument));
+    } else if (argument <= 0xff) {
+        out.push_back(static_cast<char>(type | 24));
+        append_big_endian(out, static_cast<std::uint8_t>(argument));
+    } else if (argument <= 0xffff) {
+        out.push_back(static_cast<char>(type | 25));
+        append_big_endian(out, static_cast<std::uint16_t>(argument));
+    } else if (argument <= 0xffffffff) {
+        out.push_back(static_cast<char>(type | 26));
+        append_big_endian(out, static_cast<std::uint32_t>(argument));
+    } else {
+        out.push_back(static_cast<char>(type | 27));
+        append_big_endian(out, argument);
+    }
+}
+
+/* IEEE 754 half precision, only decoded */
+double half_to_double(std::uint16_t half) {
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+} // namespace
+
+namespace serialization {
+
+void cbor_encoder::write_null(std::string& out) {
+    out.push_back(static_cast<char>(0xf6));
+}
+
+void cbor_encoder::write_bool(std::string& out, bool value) {
+    out.push_back(static_cast<char>(value ? 0xf5 : 0xf4));
+}
+
+void cbor_encoder::write_integer(std::string& out, std::int64_t value) {
+    if (value >= 0) {
+        write_head(out, 0, static_cast<std::uint64_t>(value));
+    } else {
+        /* -1 - n, written without overflowing for the minimum */
+        write_head(out, 1, ~static_cast<std::uint64_t>(value));
+    }
+}
+
+void cbor_encoder::write_unsigned(std::string& out, std::uint64_t value) {
+    write_head(out, 0, value);
+}
+
+void cbor_encoder::write_float(std::string& out, float value) {
+    out.push_back(static_cast<char>(0xfa));
+    append_big_endian(out, std::bit_cast<std::uint32_t>(value));
+}
+
+void cbor_encoder::write_double(std::string& out, double value) {
+    out.push_back(static_cast<char>(0xfb));
+    append_big_endian(out, std::bit_cast<std::uint64_t>(value));
+}
+
+void cbor_encoder::write_string(std::string& out, std::string_view value) {
+    write_head(out, 3, value.size());
+    out.append(value);
+}
+
+void cbor_encoder::write_array_header(std::string& out, std::size_t size) {
+    write_head(out, 4, size);
+}
+
+void cbor_encoder::write_map_header(std::string& out, std::size_t size) {
+    write_head(out, 5, size);
+}
+
+} // namespace serialization
+
+namespace deserialization {
+namespace detail {
+
+bool next_cbor_token(const char*& position, const char* end, binary_token& token) {
+    using kind = binary_token::kind;
+
+    while (true) {
+        if (position == end) {
+            return false;
+        }
+        const auto initial = static_cast<unsigned char>(*position++);
+        const unsigned major = initial >> 5;
+        const unsigned info = initial & 0x1f;
+
+        if (major == 7) {
+            switch (info) {
+            case 20: token.type = kind::boolean; token.boolean = false; return true;
+            case 21: token.type = kind::boolean; token.boolean = true; return true;
+            /* undefined is read as null */
+            case 22: case 23: token.type = kind::null; return true;
+            case 25: {
+                std::uint16_t bits;
+                if (not read_big_endian(position, end, bits)) {
+                    return false;
+                }
+                token.type = kind::float64;
+                token.float64 = half_to_double(bits);
+                return true;
+            }
+            case 26: {
+                std::uint32_t bits;
+                if (not read_big_endian(position, end, bits)) {
+                    return false;
+                }
+                token.type = kind::float64;
+                token.float64 = std::bit_cast<float>(bits);
+                return true;
+            }
+            case 27: {
+                std::uint64_t bits;
+                if (not read_big_endian(position, end, bits)) {
+                    return false;
+                }
+                token.type = kind::float64;
+                token.float64 = std::bit_cast<double>(bits);
+                return true;
+            }
+            default:
+                /* other simple values & the break of indefinite lengths */
+                return false;
+            }
+        }
+
+        std::uint64_t argument = info;
+        if (info == 24) {
+            std::uint8_t value;
+            if (not read_big_endian(position, end, value)) {
+                return false;
+            }
+            argument = value;
+        } else if (info == 25) {
+            std::uint16_t value;
+            if (not read_big_endian(position, end, value)) {
+                return false;
+            }
+            argument = value;
+        } else if (info == 26) {
+            std::uint32_t value;
+            if (not read_big_endian(position, end, value)) {
+                return false;
+            }
+            argument = value;
+        } else if (info == 27) {
+            if (not read_big_endian(position, end, argument)) {
+                return false;
+            }
+        } else if (info > 27) {
+            /* indefinite lengths are not supported */
+            return false;
+        }
+
+        constexpr auto int64_max = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+        switch (major) {
+        case 0:
+            if (argument <= int64_max) {
+                token.type = kind::int64;
+                token.int64 = static_cast<std::int64_t>(argument);
+            } else {
+                token.type = kind::uint64;
+                token.uint64 = argument;
+            }
+            return true;
+        case 1:
+            if (argument > int64_max) {
+                return false;
+            }
+            token.type = kind::int64;
+            token.int64 = -1 - static_cast<std::int64_t>(argument);
+            return true;
+        /* byte strings are read as strings */
+        case 2:
+        case 3:
+            if (static_cast<std::uint64_t>(end - position) < argument) {
+                return false;
+            }
+            token.type = kind::string;
+            token.string = { position, static_cast<std::size_t>(argument) };
+            position += argument;
+            return true;
+        case 4:
+            token.type = kind::array;
+            token.uint64 = argument;
+            return true;
+        case 5:
+            token.type = kind::map;
+            token.uint64 = argument;
+            return true;
+        default:
+            /* tag, the tagged item follows */
+            continue;
+        }
+    }
+}
+
+} // namespace detail
+} // namespace deserialization
+
+} // namespace datalib
+} // namespace fhttp
@@ -1,7 +1,64 @@
 #include <fhttp/data/json.h>
+#include <fhttp/data/json_reader.h>
+
+#include <array>
 
 namespace fhttp {
 namespace datalib {
+
+namespace serialization {
+
+namespace {
+
+constexpr std::array<bool, 256> needs_escape = [] {
+    std::array<bool, 256> table { };
+    for (std::size_t c = 0; c < 0x20; ++c) {
+        table[c] = true;
+    }
+    table['"'] = true;
+    table['\\'] = true;
+    return table;
+}();
+
+} // namespace
+
+void write_json_string(std::string& out, std::string_view value) {
+    constexpr std::string_view hex = "0123456789abcdef";
+
+    out.reserve(out.size() + value.size() + 2);
+    out.push_back('"');
+
+    std::size_t run_begin = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const auto byte = static_cast<unsigned char>(value[i]);
+        if (not needs_escape[byte]) {
+            continue;
+        }
+
+        out.append(value.data() + run_begin, i - run_begin);
+        run_begin = i + 1;
+
+        switch (value[i]) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        case '\b': out.append("\\b"); break;
+        case '\f': out.append("\\f"); break;
+        default:
+            out.append("\\u00");
+            out.push_back(hex[byte >> 4]);
+            out.push_back(hex[byte & 0xf]);
+        }
+    }
+
+    out.append(value.data() + run_begin, value.size() - run_begin);
+    out.push_back('"');
+}
+
+} // namespace serialization
+
 namespace utils {
 
 /// Taken from https://live.boost.org/doc/libs/1_83_0/libs/json/doc/html/json/examples.html
@@ -75,5 +132,35 @@ void pretty_print(std::ostream& os, boost::json::value const& jv, std::string* i
 }
 
 } // namespace utils
+
+namespace deserialization {
+
+namespace {
+
+struct json_read_category_impl : boost::system::error_category {
+    const char* name() const noexcept override {
+        return "fhttp.json_read";
+    }
+
+    std::string message(int value) const override {
+        switch (static_cast<json_read_error>(value)) {
+        case json_read_error::type_mismatch: return "value has a wrong type";
+        case json_read_error::missing_field: return "field is missing";
+        case json_read_error::too_deep: return "value is nested too deep";
+        case json_read_error::invalid_encoding: return "binary encoding is malformed or not supported";
+        }
+        return "unknown error";
+    }
+};
+
+} // namespace
+
+const boost::system::error_category& json_read_category() {
+    static const json_read_category_impl category { };
+    return category;
+}
+
+} // namespace deserialization
+
 } // namespace datalib
 } // namespace fhttp
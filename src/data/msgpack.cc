@@ -0,0 +1,231 @@
+#include <fhttp/data/msgpack.h>
+
+#include <bit>
+#include <cstring>
+#include <limits>
+
+namespace fhttp {
+namespace datalib {
+
+namespace {
+
+using detail::append_big_endian;
+using detail::read_big_endian;
+
+void write_header(std::string& out, std::size_t size, unsigned fix_tag, std::size_t fix_limit, unsigned tag16, unsigned tag32) {
+    if (size < fix_limit) {
+        out.push_back(static_cast<char>(fix_tag | size));
+    } else if (size <= 0xffff) {
+        out.push_back(static_cast<char>(tag16));
+        append_big_endian(out, static_cast<std::uint16_t>(size));
+    } else {
+        out.push_back(static_cast<char>(tag32));
+        append_big_endian(out, static_cast<std::uint32_t>(size));
+    }
+}
+
+} // namespace
+
+namespace serialization {
+
+void msgpack_encoder::write_null(std::string& out) {
+    out.push_back(static_cast<char>(0xc0));
+}
+
+void msgpack_encoder::write_bool(std::string& out, bool value) {
+    out.push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+}
+
+void msgpack_encoder::write_integer(std::string& out, std::int64_t value) {
+    if (value >= 0) {
+        write_unsigned(out, static_cast<std::uint64_t>(value));
+    } else if (value >= -32) {
+        out.push_back(static_cast<char>(value));
+    } else if (value >= std::numeric_limits<std::int8_t>::min()) {
+        out.push_back(static_cast<char>(0xd0));
+        append_big_endian(out, static_cast<std::uint8_t>(value));
+    } else if (value >= std::numeric_limits<std::int16_t>::min()) {
+        out.push_back(static_cast<char>(0xd1));
+        append_big_endian(out, static_cast<std::uint16_t>(value));
+    } else if (value >= std::numeric_limits<std::int32_t>::min()) {
+        out.push_back(static_cast<char>(0xd2));
+        append_big_endian(out, static_cast<std::uint32_t>(value));
+    } else {
+        out.push_back(static_cast<char>(0xd3));
+        append_big_endian(out, static_cast<std::uint64_t>(value));
+    }
+}
+
+void msgpack_encoder::write_unsigned(std::string& out, std::uint64_t value) {
+    if (value < 0x80) {
+        out.push_back(static_cast<char>(value));
+    } else if (value <= 0xff) {
+        out.push_back(static_cast<char>(0xcc));
+        append_big_endian(out, static_cast<std::uint8_t>(value));
+    } else if (value <= 0xffff) {
+        out.push_back(static_cast<char>(0xcd));
+        append_big_endian(out, static_cast<std::uint16_t>(value));
+    } else if (value <= 0xffffffff) {
+        out.push_back(static_cast<char>(0xce));
+        append_big_endian(out, static_cast<std::uint32_t>(value));
+    } else {
+        out.push_back(static_cast<char>(0xcf));
+        append_big_endian(out, value);
+    }
+}
+
+void msgpack_encoder::write_float(std::string& out, float value) {
+    out.push_back(static_cast<char>(0xca));
+    append_big_endian(out, std::bit_cast<std::uint32_t>(value));
+}
+
+void msgpack_encoder::write_double(std::string& out, double value) {
+    out.push_back(static_cast<char>(0xcb));
+    append_big_endian(out, std::bit_cast<std::uint64_t>(value));
+}
+
+void msgpack_encoder::write_string(std::string& out, std::string_view value) {
+    if (value.size() < 32) {
+        out.push_back(static_cast<char>(0xa0 | value.size()));
+    } else if (value.size() <= 0xff) {
+        out.push_back(static_cast<char>(0xd9));
+        append_big_endian(out, static_cast<std::uint8_t>(value.size()));
+    } else {
+        write_header(out, value.size(), 0, 0, 0xda, 0xdb);
+    }
+    out.append(value);
+}
+
+void msgpack_encoder::write_array_header(std::string& out, std::size_t size) {
+    write_header(out, size, 0x90, 16, 0xdc, 0xdd);
+}
+
+void msgpack_encoder::write_map_header(std::string& out, std::size_t size) {
+    write_header(out, size, 0x80, 16, 0xde, 0xdf);
+}
+
+} // namespace serialization
+
+namespace deserialization {
+namespace detail {
+
+bool next_msgpack_token(const char*& position, const char* end, binary_token& token) {
+    using kind = binary_token::kind;
+
+    if (position == end) {
+        return false;
+    }
+    const auto tag = static_cast<unsigned char>(*position++);
+
+    const auto take_string = [&](std::size_t size) {
+        if (static_cast<std::size_t>(end - position) < size) {
+            return false;
+        }
+        token.type = kind::string;
+        token.string = { position, size };
+        position += size;
+        return true;
+    };
+
+    const auto take_unsigned = [&](auto value) {
+        if (not read_big_endian(position, end, value)) {
+            return false;
+        }
+        if (value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            token.type = kind::int64;
+            token.int64 = static_cast<std::int64_t>(value);
+        } else {
+            token.type = kind::uint64;
+            token.uint64 = value;
+        }
+        return true;
+    };
+
+    const auto take_signed = [&](auto value) {
+        using signed_t = std::make_signed_t<decltype(value)>;
+        if (not read_big_endian(position, end, value)) {
+            return false;
+        }
+        token.type = kind::int64;
+        token.int64 = static_cast<signed_t>(value);
+        return true;
+    };
+
+    const auto take_container = [&](kind type, auto size) {
+        if (not read_big_endian(position, end, size)) {
+            return false;
+        }
+        token.type = type;
+        token.uint64 = size;
+        return true;
+    };
+
+    if (tag <= 0x7f) {
+        token.type = kind::int64;
+        token.int64 = tag;
+        return true;
+    } else if (tag >= 0xe0) {
+        token.type = kind::int64;
+        token.int64 = static_cast<std::int8_t>(tag);
+        return true;
+    } else if (tag <= 0x8f) {
+        token.type = kind::map;
+        token.uint64 = tag & 0x0f;
+        return true;
+    } else if (tag <= 0x9f) {
+        token.type = kind::array;
+        token.uint64 = tag & 0x0f;
+        return true;
+    } else if (tag <= 0xbf) {
+        return take_string(tag & 0x1f);
+    }
+
+    switch (tag) {
+    case 0xc0: token.type = kind::null; return true;
+    case 0xc2: token.type = kind::boolean; token.boolean = false; return true;
+    case 0xc3: token.type = kind::boolean; token.boolean = true; return true;
+    /* bin is read as a string */
+    case 0xc4: case 0xd9: { std::uint8_t size; return read_big_endian(position, end, size) and take_string(size); }
+    case 0xc5: case 0xda: { std::uint16_t size; return read_big_endian(position, end, size) and take_string(size); }
+    case 0xc6: case 0xdb: { std::uint32_t size; return read_big_endian(position, end, size) and take_string(size); }
+    case 0xca: {
+        std::uint32_t bits;
+        if (not read_big_endian(position, end, bits)) {
+            return false;
+        }
+        token.type = kind::float64;
+        token.float64 = std::bit_cast<float>(bits);
+        return true;
+    }
+    case 0xcb: {
+        std::uint64_t bits;
+        if (not read_big_endian(position, end, bits)) {
+            return false;
+        }
+        token.type = kind::float64;
+        token.float64 = std::bit_cast<double>(bits);
+        return true;
+    }
+    case 0xcc: return take_unsigned(std::uint8_t { });
+    case 0xcd: return take_unsigned(std::uint16_t { });
+    case 0xce: return take_unsigned(std::uint32_t { });
+    case 0xcf: return take_unsigned(std::uint64_t { });
+    case 0xd0: return take_signed(std::uint8_t { });
+    case 0xd1: return take_signed(std::uint16_t { });
+    case 0xd2: return take_signed(std::uint32_t { });
+    case 0xd3: return take_signed(std::uint64_t { });
+    case 0xdc: return take_container(kind::array, std::uint16_t { });
+    case 0xdd: return take_container(kind::array, std::uint32_t { });
+    case 0xde: return take_container(kind::map, std::uint16_t { });
+    case 0xdf: return take_container(kind::map, std::uint32_t { });
+    default:
+        /* 0xc1 is never used, ext & fixext types are not supported */
+        return false;
+    }
+}
+
+} // namespace detail
+} // namespace deserialization
+
+} // namespace datalib
+} // namespace fhttp
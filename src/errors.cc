@@ -0,0 +1,70 @@
+#include <fhttp/errors.h>
+#include <fhttp/headers.h>
+#include <fhttp/status_codes.h>
+#include <fhttp/data/json.h>
+
+namespace fhttp {
+
+namespace {
+
+std::string_view default_message(request_error error) {
+    switch (error) {
+        case request_error::malformed_request: return "Request can't be parsed";
+        case request_error::invalid_content_length: return "Invalid Content-Length";
+        case request_error::payload_too_large: return "Request body is too large";
+        case request_error::method_not_implemented: return "Method is not implemented";
+        case request_error::transfer_coding_not_implemented: return "Transfer coding is not implemented";
+        case request_error::invalid_body: return "Request body can't be decoded";
+        case request_error::invalid_query_parameter: return "Invalid query parameter";
+        case request_error::invalid_path_parameter: return "Invalid path parameter";
+        case request_error::internal_error: return "Internal server error";
+    }
+    return "Unknown error";
+}
+
+} // namespace
+
+int status_code_of(request_error error) {
+    switch (error) {
+        case request_error::malformed_request: return STATUS_CODE_BAD_REQUEST;
+        case request_error::invalid_content_length: return STATUS_CODE_BAD_REQUEST;
+        case request_error::payload_too_large: return STATUS_CODE_PAYLOAD_TOO_LARGE;
+        case request_error::method_not_implemented: return STATUS_CODE_NOT_IMPLEMENTED;
+        case request_error::transfer_coding_not_implemented: return STATUS_CODE_NOT_IMPLEMENTED;
+        case request_error::invalid_body: return STATUS_CODE_BAD_REQUEST;
+        case request_error::invalid_query_parameter: return STATUS_CODE_BAD_REQUEST;
+        case request_error::invalid_path_parameter: return STATUS_CODE_BAD_REQUEST;
+        case request_error::internal_error: return STATUS_CODE_INTERNAL_SERVER_ERROR;
+    }
+    return STATUS_CODE_INTERNAL_SERVER_ERROR;
+}
+
+std::string_view name_of(request_error error) {
+    switch (error) {
+        case request_error::malformed_request: return "malformed_request";
+        case request_error::invalid_content_length: return "invalid_content_length";
+        case request_error::payload_too_large: return "payload_too_large";
+        case request_error::method_not_implemented: return "method_not_implemented";
+        case request_error::transfer_coding_not_implemented: return "transfer_coding_not_implemented";
+        case request_error::invalid_body: return "invalid_body";
+        case request_error::invalid_query_parameter: return "invalid_query_parameter";
+        case request_error::invalid_path_parameter: return "invalid_path_parameter";
+        case request_error::internal_error: return "internal_error";
+    }
+    return "unknown_error";
+}
+
+void set_error_response(response<std::string>& resp, request_error error, std::string_view message) {
+    resp.status_code = status_code_of(error);
+    resp.headers[HEADER_CONTENT_TYPE] = "application/json";
+
+    auto& body = resp.body;
+    body.clear();
+    body.append("{\"status\":");
+    detail::append_number(body, static_cast<std::size_t>(resp.status_code));
+    body.append(",\"error\":\"").append(name_of(error)).append("\",\"message\":");
+    datalib::serialization::write_json_string(body, message.empty() ? default_message(error) : message);
+    body.push_back('}');
+}
+
+} // namespace fhttp
@@ -0,0 +1,149 @@
+#include <fhttp/file_cache.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <mutex>
+#include <utility>
+#include <format>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fhttp {
+
+cached_file::cached_file(int fd, std::size_t size, std::time_t modified_at, std::uint64_t inode, std::string content_type)
+    : fd { fd }
+    , size { size }
+    , modified_at { modified_at }
+    , inode { inode }
+    , content_type { std::move(content_type) }
+    , checked_at { std::chrono::steady_clock::now() }
+{
+    etag = std::format("\"{:x}-{:x}-{:x}\"", inode, size, static_cast<std::uint64_t>(modified_at));
+    last_modified = http_date(modified_at);
+}
+
+cached_file::~cached_file() {
+    ::close(fd);
+}
+
+std::shared_ptr<const cached_file> file_cache::get(const std::string& path) {
+    const auto now = std::chrono::steady_clock::now();
+
+    {
+        std::shared_lock lock { mutex };
+        const auto it = files.find(path);
+        if (it != files.end() and now - it->second->checked_at < revalidate_interval) {
+            return it->second;
+        }
+    }
+
+    struct stat file_stat;
+    if (::stat(path.c_str(), &file_stat) != 0 or not S_ISREG(file_stat.st_mode)) {
+        std::unique_lock lock { mutex };
+        files.erase(path);
+        return nullptr;
+    }
+
+    {
+        std::unique_lock lock { mutex };
+        const auto it = files.find(path);
+        if (
+            it != files.end()
+            and it->second->inode == static_cast<std::uint64_t>(file_stat.st_ino)
+            and it->second->size == static_cast<std::size_t>(file_stat.st_size)
+            and it->second->modified_at == file_stat.st_mtime
+        ) {
+            it->second->checked_at = now;
+            return it->second;
+        }
+    }
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    /* stat the opened descriptor, file could have been replaced in the meantime */
+    if (::fstat(fd, &file_stat) != 0 or not S_ISREG(file_stat.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto file = std::make_shared<cached_file>(
+        fd,
+        static_cast<std::size_t>(file_stat.st_size),
+        file_stat.st_mtime,
+        static_cast<std::uint64_t>(file_stat.st_ino),
+        std::string { mime_type(path) }
+    );
+
+    std::unique_lock lock { mutex };
+    if (files.size() >= max_entries and not files.contains(path)) {
+        files.erase(files.begin());
+    }
+    files[path] = file;
+
+    return file;
+}
+
+std::string_view mime_type(std::string_view path) {
+    static constexpr std::array<std::pair<std::string_view, std::string_view>, 24> types {{
+        { "html", "text/html" },
+        { "htm", "text/html" },
+        { "css", "text/css" },
+        { "js", "text/javascript" },
+        { "mjs", "text/javascript" },
+        { "json", "application/json" },
+        { "txt", "text/plain" },
+        { "csv", "text/csv" },
+        { "xml", "application/xml" },
+        { "svg", "image/svg+xml" },
+        { "png", "image/png" },
+        { "jpg", "image/jpeg" },
+        { "jpeg", "image/jpeg" },
+        { "gif", "image/gif" },
+        { "webp", "image/webp" },
+        { "ico", "image/x-icon" },
+        { "woff", "font/woff" },
+        { "woff2", "font/woff2" },
+        { "ttf", "font/ttf" },
+        { "pdf", "application/pdf" },
+        { "zip", "application/zip" },
+        { "gz", "application/gzip" },
+        { "mp4", "video/mp4" },
+        { "wasm", "application/wasm" },
+    }};
+
+    const auto dot = path.find_last_of('.');
+    if (dot == std::string_view::npos or path.find('/', dot) != std::string_view::npos) {
+        return "application/octet-stream";
+    }
+
+    const auto extension = path.substr(dot + 1);
+    for (const auto& [known_extension, type] : types) {
+        if (
+            known_extension.size() == extension.size()
+            and std::equal(known_extension.begin(), known_extension.end(), extension.begin(), [] (char a, char b) {
+                return a == std::tolower(static_cast<unsigned char>(b));
+            })
+        ) {
+            return type;
+        }
+    }
+
+    return "application/octet-stream";
+}
+
+std::string http_date(std::time_t time) {
+    std::tm tm { };
+    gmtime_r(&time, &tm);
+
+    char formatted[64];
+    const auto size = std::strftime(formatted, sizeof(formatted), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return { formatted, size };
+}
+
+} // namespace fhttp
@@ -1,31 +1,60 @@
 #include <fhttp/http_server.h>
 
+#include <cerrno>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/sendfile.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace fhttp {
 
-connection::connection(boost::asio::io_service& io_service, std::function<void(request<std::string>&, response<std::string>&)>&& handle_request, const std::string& server_header)
+connection::connection(boost::asio::io_service& io_service, request_handler_t&& handle_request, view_handler_t&& handle_view, body_start_handler_t&& prepare_body, const std::string& server_header)
     : io_service { io_service }
     , strand { io_service }
     , socket { io_service }
     , handle_request { handle_request }
+    , handle_view { handle_view }
     , keep_alive_timer { io_service }
     , server_header { server_header }
-{ }
+{
+    parser.on_body_start(std::move(prepare_body));
+}
 
 void connection::start() {
     FHTTP_LOG(INFO) << "Processing incomming connectiong from " << socket.remote_endpoint().address().to_string();
     socket.set_option(boost::asio::ip::tcp::no_delay(true));
-    socket.async_read_some(boost::asio::buffer(buffer),
-            boost::bind(&connection::handle_read, shared_from_this(),
-            boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
+    /* reads are done synchronously once the socket reports readiness, so they must never block */
+    socket.non_blocking(true);
+    listen_again();
 }
 
 void connection::set_keep_alive_timeout(std::chrono::steady_clock::duration timeout) {
     keep_alive_timeout = timeout;
 }
 
-void connection::handle_read(const boost::system::error_code& e, std::size_t bytes_read) {
+void connection::handle_readable(const boost::system::error_code& e) {
+    /* Client is gone (or the socket was closed), a running keep-alive timer would hold the connection until it expires */
     if (e) {
+        close_socket();
+        return;
+    }
+
+    auto buffer = buffer_pool::local().lease(read_buffer_size);
+
+    boost::system::error_code read_error;
+    const auto bytes_read = socket.read_some(boost::asio::buffer(buffer.data(), buffer.size()), read_error);
+
+    if (read_error == boost::asio::error::would_block) {
+        listen_again();
+        return;
+    }
+
+    if (read_error) {
+        close_socket();
         return;
     }
 
@@ -33,65 +62,371 @@ void connection::handle_read(const boost::system::error_code& e, std::size_t byt
         stop_keep_alive_timer();
     }
 
-    boost::tribool result;
-    boost::tie(result, boost::tuples::ignore) = parser.parse(
-        current_request, buffer.data(), buffer.data() + bytes_read);
+    handle_read(buffer.data(), buffer.data() + bytes_read);
+
+    /* Whole buffer got filled and request is still not complete (e.g. huge headers), read more next time */
+    if (bytes_read == buffer.size() and parser.is_in_progress()) {
+        read_buffer_size = std::min(read_buffer_size * 2, buffer_pool::max_buffer_size);
+    }
+
+    buffer.release();
+
+    if (pending_responses.empty()) {
+        listen_again();
+        return;
+    }
 
-    if (result) {
-        // handle request
-        response<std::string> response { };
+    write_pending_responses();
+}
 
-        if (current_request.headers.count("Cookie")) {
-            current_request.cookies.parse(current_request.headers["Cookie"]);
+void connection::handle_read(const char* begin, const char* end) {
+    /* Clients may pipeline requests, so keep parsing until the whole read is consumed */
+    while (begin != end and not should_stop) {
+        /* Fast path, whole request is within this read, so it can be handled without copying anything */
+        if (not parser.is_in_progress()) {
+            if (const auto size = request_parser::parse_view(current_view, std::string_view(begin, static_cast<std::size_t>(end - begin)), request_header_filter, max_body_size)) {
+                dispatch_view();
+                begin += *size;
+                continue;
+            }
         }
 
-        response.headers["Server"] = server_header;
+        boost::tribool result;
+        boost::tie(result, begin) = parser.parse(current_request, begin, end);
 
-        try {
-            handle_request(current_request, response);
-        } catch (const std::exception& e) {
-            FHTTP_LOG(WARNING) << "Exception caught while handling request: " << e.what();
-            response.status_code = 500;
-            response.body = "Internal server error";
+        if (result) {
+            dispatch_request();
+            reset_request();
+        } else if (!result) {
+            /* Malformed request is answered and the connection closed, the rest of the read can't be trusted either */
+            response<std::string> response { };
+            response.headers[HEADER_SERVER] = server_header;
+            set_error_response(response, parser.error());
+            queue_response(std::move(response), 1, 1, true);
+            reset_request();
+            break;
         }
+    }
+}
+
+void connection::dispatch_request() {
+    response<std::string> response { };
+    if (not recycled_bodies.empty()) {
+        response.body = std::move(recycled_bodies.back());
+        recycled_bodies.pop_back();
+    }
+
+    response.headers[HEADER_SERVER] = server_header;
+    current_request.arena = &arena;
+
+    try {
+        handle_request(current_request, response);
+    } catch (const std::exception& e) {
+        /* only handlers may throw, decoding reports its errors as responses */
+        FHTTP_LOG(WARNING) << "Exception caught while handling request: " << e.what();
+        set_error_response(response, request_error::internal_error);
+    }
+
+    queue_response(
+        std::move(response),
+        current_request.http_version_major,
+        current_request.http_version_minor,
+        current_request.headers.keep_alive() == false
+    );
+}
+
+void connection::dispatch_view() {
+    response<std::string> response { };
+    if (not recycled_bodies.empty()) {
+        response.body = std::move(recycled_bodies.back());
+        recycled_bodies.pop_back();
+    }
+
+    response.headers[HEADER_SERVER] = server_header;
+    current_view.arena = &arena;
+
+    try {
+        handle_view(current_view, response);
+    } catch (const std::exception& e) {
+        /* only handlers may throw, decoding reports its errors as responses */
+        FHTTP_LOG(WARNING) << "Exception caught while handling request: " << e.what();
+        set_error_response(response, request_error::internal_error);
+    }
+
+    queue_response(
+        std::move(response),
+        current_view.http_version_major,
+        current_view.http_version_minor,
+        current_view.headers.keep_alive() == false
+    );
+}
+
+void connection::queue_response(response<std::string>&& response, int http_version_major, int http_version_minor, bool close_requested) {
+    if (http_version_major != 1 or close_requested) {
+        should_stop = true;
+    }
 
-        if (
-            current_request.http_version_major != 1 
-            or (
-                current_request.headers.count("Connection") 
-                and current_request.headers["Connection"] == "close"
-            )
-        ) {
+    /* HTTP/1.0 client doesn't understand chunked coding, stream of unknown length is delimited by closing the connection */
+    if (response.body_stream and http_version_minor == 0) {
+        response.version = "HTTP/1.0";
+        if (not response.body_stream.content_length) {
             should_stop = true;
         }
+    }
+
+    pending_responses.push_back(std::move(response));
+}
+
+void connection::release_pending_responses() {
+    for (auto& response : pending_responses) {
+        if (recycled_bodies.size() == max_recycled_bodies) {
+            break;
+        }
+        if (response.body.capacity() > 0 and response.body.capacity() <= max_recycled_body_capacity) {
+            response.body.clear();
+            recycled_bodies.push_back(std::move(response.body));
+        }
+    }
+
+    pending_responses.clear();
+    arena.release();
+}
+
+void connection::reset_request() {
+    current_request = request<std::string> { };
+    parser.reset();
+}
+
+void connection::write_pending_responses() {
+    /* Heads & bodies up to (and including the head of) the first streamed response go out together */
+    const auto first = next_pending_response;
+    auto last = first;
+
+    header_buffer.clear();
+    header_sizes.clear();
+    for (; last < pending_responses.size(); ++last) {
+        const auto& response = pending_responses[last];
+        const auto size_before = header_buffer.size();
+
+        if (response.body_stream) {
+            response.serialize_head(header_buffer, response.body_stream.content_length);
+            header_sizes.push_back(header_buffer.size() - size_before);
+            is_streaming_response = true;
+            streamed_body_size = 0;
+            ++last;
+            break;
+        }
+
+        if (response.body_file) {
+            response.serialize_head(header_buffer, response.body_file.size());
+            header_sizes.push_back(header_buffer.size() - size_before);
+            is_sending_file = true;
+            file_part = 0;
+            is_file_part_prefix_sent = false;
+            ++last;
+            break;
+        }
+
+        response.serialize_head(header_buffer, response.body.size());
+        header_sizes.push_back(header_buffer.size() - size_before);
+    }
+    next_pending_response = last;
+
+    /* header_buffer is complete now, so it's safe to point into it, head & body go out as one gathered write */
+    pending_buffers.clear();
+    std::size_t header_offset = 0;
+    for (std::size_t i = first; i < last; ++i) {
+        const auto header_size = header_sizes[i - first];
+        pending_buffers.push_back(boost::asio::buffer(header_buffer.data() + header_offset, header_size));
+        header_offset += header_size;
+
+        if (not pending_responses[i].body.empty() and not pending_responses[i].body_stream and not pending_responses[i].body_file) {
+            pending_buffers.push_back(boost::asio::buffer(pending_responses[i].body));
+        }
+    }
+
+    boost::asio::async_write(socket, pending_buffers,
+        boost::bind(&connection::post_response_sent, shared_from_this(),
+        boost::asio::placeholders::error));
+}
+
+void connection::write_next_chunk() {
+    const auto& response = pending_responses[next_pending_response - 1];
+
+    chunk_buffer.clear();
+    bool has_more = false;
+    try {
+        has_more = response.body_stream.producer(chunk_buffer);
+    } catch (const std::exception& e) {
+        /* Head is already out, so there's no way to tell the client other than cutting the connection */
+        FHTTP_LOG(WARNING) << "Exception caught while producing response body: " << e.what();
+        close_socket();
+        return;
+    }
+
+    /* Client reads exactly the declared length: extra bytes are cut, and either way a body of another length
+       leaves the connection out of sync, so it's closed (with the responses queued after this one) once it's out */
+    if (const auto& content_length = response.body_stream.content_length; content_length) {
+        const auto remaining = *content_length - streamed_body_size;
+        const bool is_too_long = chunk_buffer.size() > remaining;
+        if (is_too_long) {
+            chunk_buffer.resize(remaining);
+            has_more = false;
+        }
+        streamed_body_size += chunk_buffer.size();
+
+        if (is_too_long or (not has_more and streamed_body_size != *content_length)) {
+            FHTTP_LOG(WARNING) << "Streamed response body doesn't match its Content-Length of " << *content_length
+                << ", closing the connection";
+            should_stop = true;
+            pending_responses.erase(pending_responses.begin() + next_pending_response, pending_responses.end());
+        }
+    }
+
+    pending_buffers.clear();
+    chunk_header_buffer.clear();
+
+    if (response.is_chunked()) {
+        if (not chunk_buffer.empty()) {
+            detail::append_hex_number(chunk_header_buffer, chunk_buffer.size());
+            chunk_header_buffer.append("\r\n");
+            pending_buffers.push_back(boost::asio::buffer(chunk_header_buffer));
+            pending_buffers.push_back(boost::asio::buffer(chunk_buffer));
+            pending_buffers.push_back(boost::asio::buffer("\r\n", 2));
+        }
+        if (not has_more) {
+            pending_buffers.push_back(boost::asio::buffer("0\r\n\r\n", 5));
+        }
+    } else if (not chunk_buffer.empty()) {
+        pending_buffers.push_back(boost::asio::buffer(chunk_buffer));
+    }
+
+    is_streaming_response = has_more;
+
+    boost::asio::async_write(socket, pending_buffers,
+        boost::bind(&connection::post_response_sent, shared_from_this(),
+        boost::asio::placeholders::error));
+}
+
+void connection::send_file() {
+    auto& parts = pending_responses[next_pending_response - 1].body_file.parts;
+
+    for (; file_part < parts.size(); ++file_part, is_file_part_prefix_sent = false) {
+        auto& [prefix, region] = parts[file_part];
+
+        /* In-memory bytes preceding the region (multipart/byteranges part headers) */
+        if (not is_file_part_prefix_sent and not prefix.empty()) {
+            is_file_part_prefix_sent = true;
+            boost::asio::async_write(socket, boost::asio::buffer(prefix),
+                boost::bind(&connection::post_response_sent, shared_from_this(),
+                boost::asio::placeholders::error));
+            return;
+        }
+        is_file_part_prefix_sent = true;
+
+        if (not send_file_region(region)) {
+            return;
+        }
+    }
+
+    is_sending_file = false;
+    post_response_sent(boost::system::error_code { });
+}
+
+bool connection::send_file_region(file_region& region) {
+    while (region.length > 0) {
+#ifdef __linux__
+        /* Straight from the page cache to the socket, socket is non-blocking so wait once its buffer is full */
+        auto offset = static_cast<off_t>(region.offset);
+        const auto sent = ::sendfile(socket.native_handle(), region.file->fd, &offset, region.length);
+
+        if (sent < 0 and errno == EINTR) {
+            continue;
+        }
+
+        if (sent < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+            socket.async_wait(boost::asio::ip::tcp::socket::wait_write,
+                boost::bind(&connection::handle_writable, shared_from_this(),
+                boost::asio::placeholders::error));
+            return false;
+        }
+
+        /* Error or file got truncated, Content-Length can't be satisfied anymore */
+        if (sent <= 0) {
+            FHTTP_LOG(WARNING) << "Failed to send file, closing connection";
+            close_socket();
+            return false;
+        }
+
+        region.offset += static_cast<std::size_t>(sent);
+        region.length -= static_cast<std::size_t>(sent);
+#else
+        chunk_buffer.resize(std::min<std::size_t>(region.length, buffer_pool::max_buffer_size));
+        const auto n = ::pread(region.file->fd, chunk_buffer.data(), chunk_buffer.size(), static_cast<off_t>(region.offset));
+        if (n <= 0) {
+            FHTTP_LOG(WARNING) << "Failed to read file, closing connection";
+            close_socket();
+            return false;
+        }
+
+        chunk_buffer.resize(static_cast<std::size_t>(n));
+        region.offset += chunk_buffer.size();
+        region.length -= chunk_buffer.size();
 
-        const auto response_string = response.to_string();
-        boost::asio::async_write(socket, boost::asio::buffer(response_string.data(), response_string.size()),
+        boost::asio::async_write(socket, boost::asio::buffer(chunk_buffer),
             boost::bind(&connection::post_response_sent, shared_from_this(),
             boost::asio::placeholders::error));
+        return false;
+#endif
+    }
 
-    } else if (!result) {
-        listen_again();
-    } else {
-        socket.async_read_some(boost::asio::buffer(buffer),
-            boost::bind(&connection::handle_read, shared_from_this(),
-            boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
+    return true;
+}
+
+void connection::handle_writable(const boost::system::error_code& e) {
+    if (e) {
+        close_socket();
+        return;
     }
+
+    send_file();
 }
 
 void connection::listen_again() {
-    current_request = request<std::string> { };
-    parser.reset();
-    
-    socket.async_read_some(boost::asio::buffer(buffer),
-        boost::bind(&connection::handle_read, shared_from_this(),
-        boost::asio::placeholders::error,
-        boost::asio::placeholders::bytes_transferred));
+    /* zero-byte readiness wait, buffer is leased only once there's something to read */
+    socket.async_wait(boost::asio::ip::tcp::socket::wait_read,
+        boost::bind(&connection::handle_readable, shared_from_this(),
+        boost::asio::placeholders::error));
 }
 
 void connection::post_response_sent(const boost::system::error_code& e) {
-    if (e or should_stop) {
+    if (e) {
+        release_pending_responses();
+        close_socket();
+        return;
+    }
+
+    /* Previous write was flow controlled, produce the next piece only once the previous one is out */
+    if (is_streaming_response) {
+        write_next_chunk();
+        return;
+    }
+
+    if (is_sending_file) {
+        send_file();
+        return;
+    }
+
+    if (next_pending_response < pending_responses.size()) {
+        write_pending_responses();
+        return;
+    }
+
+    release_pending_responses();
+    pending_buffers.clear();
+    next_pending_response = 0;
+
+    if (should_stop) {
         close_socket();
         return;
     }
@@ -101,6 +436,11 @@ void connection::post_response_sent(const boost::system::error_code& e) {
 }
 
 void connection::close_socket() {
+    /* Pending timer would keep the connection alive (and out of the pool) until it expires */
+    if (is_keep_alive_timer_running) {
+        stop_keep_alive_timer();
+    }
+
     boost::system::error_code ignored_ec;
     socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
     socket.close(ignored_ec);
@@ -137,9 +477,103 @@ void connection::stop_keep_alive_timer() {
     keep_alive_timer.cancel();
 }
 
+void connection::set_max_chunk_size(std::size_t size) {
+    parser.set_max_chunk_size(size);
+}
+
+void connection::set_max_body_size(std::size_t size) {
+    max_body_size = size;
+    parser.set_max_body_size(size);
+}
+
+void connection::set_header_filter(const header_filter* filter) {
+    request_header_filter = filter;
+    parser.set_header_filter(filter);
+}
+
 boost::asio::ip::tcp::socket& connection::get_socket() {
     return socket;
 }
 
+void connection::reset() {
+    reset_request();
+
+    release_pending_responses();
+    recycled_bodies.clear();
+    pending_buffers.clear();
+    header_buffer.clear();
+    header_sizes.clear();
+    next_pending_response = 0;
+    is_streaming_response = false;
+    is_sending_file = false;
+    file_part = 0;
+    is_file_part_prefix_sent = false;
+    chunk_buffer.clear();
+    streamed_body_size = 0;
+
+    should_stop = false;
+    is_keep_alive_timer_running = false;
+    read_buffer_size = default_read_buffer_size;
+
+    boost::system::error_code ignored_ec;
+    socket.close(ignored_ec);
+}
+
+connection_pool::connection_pool(boost::asio::io_service& io_service, request_handler_t handle_request, view_handler_t handle_view, body_start_handler_t prepare_body, const std::string& server_header, std::size_t max_size)
+    : io_service { io_service }
+    , handle_request { std::move(handle_request) }
+    , handle_view { std::move(handle_view) }
+    , prepare_body { std::move(prepare_body) }
+    , server_header { server_header }
+    , max_size { max_size }
+{ }
+
+std::shared_ptr<connection> connection_pool::acquire() {
+    std::unique_ptr<connection> conn;
+
+    {
+        std::lock_guard lock { mutex };
+        if (not free_connections.empty()) {
+            conn = std::move(free_connections.back());
+            free_connections.pop_back();
+        }
+    }
+
+    if (not conn) {
+        conn = std::make_unique<connection>(io_service, request_handler_t { handle_request }, view_handler_t { handle_view }, body_start_handler_t { prepare_body }, server_header);
+    }
+
+    /* Deleter holds the pool, so it's still around even if connection outlives the server's shard */
+    return std::shared_ptr<connection>(conn.release(), [pool = shared_from_this()] (connection* conn) {
+        pool->release(conn);
+    });
+}
+
+void connection_pool::release(connection* conn) {
+    std::unique_ptr<connection> owned { conn };
+    owned->reset();
+
+    std::lock_guard lock { mutex };
+    if (free_connections.size() < max_size) {
+        free_connections.push_back(std::move(owned));
+    }
+}
+
+
+void pin_current_thread(std::size_t cpu) {
+#ifdef __linux__
+    const auto n_cpus = std::max(1u, std::thread::hardware_concurrency());
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu % n_cpus, &cpu_set);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        FHTTP_LOG(WARNING) << "Failed to pin thread to CPU " << cpu % n_cpus;
+    }
+#else
+    FHTTP_UNUSED(cpu);
+#endif
+}
 
 } // namespace fhttp
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <fhttp/key_value_view.h>
+#include <fhttp/query.h>
+
+#include "text.h"
+
+namespace fhttp {
+
+using detail::trim;
+
+key_value_view::iterator::iterator(std::string_view rest, char separator)
+    : rest(rest)
+    , separator(separator)
+    , is_end(false)
+{
+    advance();
+}
+
+void key_value_view::iterator::advance() {
+    while (not rest.empty()) {
+        const auto pair_end = rest.find(separator);
+        const auto pair = rest.substr(0, pair_end);
+        rest = pair_end == std::string_view::npos ? rest.substr(rest.size()) : rest.substr(pair_end + 1);
+
+        const auto equals = pair.find('=');
+        const auto name = trim(pair.substr(0, equals));
+        if (name.empty()) {
+            continue;
+        }
+
+        current = { name, equals == std::string_view::npos ? std::string_view { } : trim(pair.substr(equals + 1)) };
+        return;
+    }
+    is_end = true;
+}
+
+std::optional<std::string_view> key_value_view::get(std::string_view name) const {
+    for (const auto& [key, value] : *this) {
+        if (key == name) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> key_value_view::get_decoded(std::string_view name) const {
+    const auto value = get(name);
+    if (not value) {
+        return std::nullopt;
+    }
+    return percent_decoded(*value);
+}
+
+} // namespace fhttp
@@ -0,0 +1,117 @@
+#include <fhttp/query.h>
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace fhttp {
+
+namespace {
+
+/* First '%' or '+' in [begin, end), 32 (AVX2) or 16 (SSE2) bytes per iteration, the tail byte by byte */
+const char* find_escape(const char* begin, const char* end) {
+#if defined(__AVX2__)
+    {
+        const auto percent = _mm256_set1_epi8('%');
+        const auto plus = _mm256_set1_epi8('+');
+
+        for (; end - begin >= 32; begin += 32) {
+            const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, percent), _mm256_cmpeq_epi8(bytes, plus))));
+            if (mask != 0) {
+                return begin + std::countr_zero(mask);
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    {
+        const auto percent = _mm_set1_epi8('%');
+        const auto plus = _mm_set1_epi8('+');
+
+        for (; end - begin >= 16; begin += 16) {
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, percent), _mm_cmpeq_epi8(bytes, plus))));
+            if (mask != 0) {
+                return begin + std::countr_zero(mask);
+            }
+        }
+    }
+#endif
+
+    for (; begin != end; ++begin) {
+        if (*begin == '%' or *begin == '+') {
+            return begin;
+        }
+    }
+    return end;
+}
+
+int hex_value(char c) {
+    if (c >= '0' and c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' and c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' and c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace
+
+std::size_t percent_decode(char* data, std::size_t size) {
+    const char* in = data;
+    const char* const end = data + size;
+    char* out = data;
+
+    while (in != end) {
+        const char* escape = find_escape(in, end);
+        const auto run = static_cast<std::size_t>(escape - in);
+
+        /* nothing was decoded yet, so the run is already in place */
+        if (out != in) {
+            std::memmove(out, in, run);
+        }
+        out += run;
+        in = escape;
+
+        if (in == end) {
+            break;
+        }
+
+        if (*in == '+') {
+            *out++ = ' ';
+            ++in;
+            continue;
+        }
+
+        const auto high = end - in >= 3 ? hex_value(in[1]) : -1;
+        const auto low = end - in >= 3 ? hex_value(in[2]) : -1;
+        if (high < 0 or low < 0) {
+            *out++ = *in++;
+            continue;
+        }
+
+        *out++ = static_cast<char>(high * 16 + low);
+        in += 3;
+    }
+
+    return static_cast<std::size_t>(out - data);
+}
+
+std::string percent_decoded(std::string_view value) {
+    std::string result { value };
+    result.resize(percent_decode(result.data(), result.size()));
+    return result;
+}
+
+} // namespace fhttp
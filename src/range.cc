@@ -0,0 +1,98 @@
+#include <fhttp/range.h>
+
+#include <charconv>
+#include <optional>
+
+#include "text.h"
+
+namespace fhttp {
+
+using detail::trim;
+
+namespace {
+
+std::optional<std::size_t> parse_number(std::string_view value) {
+    std::size_t number = 0;
+    const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc { } or end != value.data() + value.size() or value.empty()) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+} // namespace
+
+range_request parse_range(std::string_view header, std::size_t size, std::size_t max_ranges) {
+    constexpr std::string_view unit = "bytes=";
+
+    header = trim(header);
+    if (not header.starts_with(unit)) {
+        return { };
+    }
+    header.remove_prefix(unit.size());
+
+    range_request result { };
+    std::size_t n_specs = 0;
+
+    while (not header.empty()) {
+        const auto comma = header.find(',');
+        const auto spec = trim(header.substr(0, comma));
+        header = comma == std::string_view::npos ? std::string_view { } : header.substr(comma + 1);
+
+        if (spec.empty()) {
+            continue;
+        }
+
+        if (++n_specs > max_ranges) {
+            return { };
+        }
+
+        const auto dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            return { };
+        }
+
+        const auto first = spec.substr(0, dash);
+        const auto last = spec.substr(dash + 1);
+
+        if (first.empty()) {
+            /* suffix range, last N bytes */
+            const auto suffix_length = parse_number(last);
+            if (not suffix_length) {
+                return { };
+            }
+            if (*suffix_length > 0 and size > 0) {
+                const auto length = std::min(*suffix_length, size);
+                result.ranges.push_back({ size - length, length });
+            }
+            continue;
+        }
+
+        const auto first_byte = parse_number(first);
+        if (not first_byte) {
+            return { };
+        }
+
+        std::size_t last_byte = size - 1;
+        if (not last.empty()) {
+            const auto parsed_last = parse_number(last);
+            if (not parsed_last or *parsed_last < *first_byte) {
+                return { };
+            }
+            last_byte = std::min(*parsed_last, size - 1);
+        }
+
+        if (*first_byte < size) {
+            result.ranges.push_back({ *first_byte, last_byte - *first_byte + 1 });
+        }
+    }
+
+    if (n_specs == 0) {
+        return { };
+    }
+
+    result.status = result.ranges.empty() ? range_status::unsatisfiable : range_status::satisfiable;
+    return result;
+}
+
+} // namespace fhttp
@@ -16,7 +16,7 @@ const char* method_to_string(method method) {
     }
 }
 
-std::optional<method> string_to_method(const std::string& str) {
+std::optional<method> string_to_method(std::string_view str) {
     if (str == "GET") return method::get;
     if (str == "POST") return method::post;
     if (str == "PUT") return method::put;
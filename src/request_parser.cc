@@ -1,24 +1,289 @@
 #include <fhttp/request_parser.h>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace fhttp {
 
+namespace {
+
+/* Bytes allowed in a method or a header name, same as !is_ctl && is_char && !is_tspecial */
+constexpr std::array<bool, 256> token_table = [] {
+  std::array<bool, 256> table { };
+  constexpr std::string_view tspecials = "()<>@,;:\\\"/[]?={} \t";
+  for (int c = 32; c < 127; ++c) {
+    table[c] = tspecials.find(static_cast<char>(c)) == std::string_view::npos;
+  }
+  return table;
+}();
+
+bool is_token(char c) {
+  return token_table[static_cast<unsigned char>(c)];
+}
+
+/// First byte in [begin, end) that's a control character, the `delimiter` or, with `stop_at_non_ascii`,
+/// a byte >= 0x80. Checks 32 (AVX2) or 16 (SSE2) bytes per iteration, the tail is checked byte by byte.
+const char* find_run_end(const char* begin, const char* end, char delimiter, bool stop_at_non_ascii) {
+#if defined(__AVX2__)
+  {
+    const auto delimiters = _mm256_set1_epi8(delimiter);
+    const auto last_ctl = _mm256_set1_epi8(0x1f);
+    const auto del = _mm256_set1_epi8(0x7f);
+
+    for (; end - begin >= 32; begin += 32) {
+      const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+      const auto stop = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, last_ctl), bytes),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, del), _mm256_cmpeq_epi8(bytes, delimiters)));
+
+      auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(stop));
+      if (stop_at_non_ascii) {
+        mask |= static_cast<std::uint32_t>(_mm256_movemask_epi8(bytes));
+      }
+      if (mask != 0) {
+        return begin + std::countr_zero(mask);
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const auto delimiters = _mm_set1_epi8(delimiter);
+    const auto last_ctl = _mm_set1_epi8(0x1f);
+    const auto del = _mm_set1_epi8(0x7f);
+
+    for (; end - begin >= 16; begin += 16) {
+      const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+      const auto stop = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_min_epu8(bytes, last_ctl), bytes),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, del), _mm_cmpeq_epi8(bytes, delimiters)));
+
+      auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(stop));
+      if (stop_at_non_ascii) {
+        mask |= static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+      }
+      if (mask != 0) {
+        return begin + std::countr_zero(mask);
+      }
+    }
+  }
+#endif
+
+  for (; begin != end; ++begin) {
+    const auto c = static_cast<unsigned char>(*begin);
+    if (c < 0x20 || c == 0x7f || *begin == delimiter || (stop_at_non_ascii && c >= 0x80)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+} // namespace
+
 request_parser::request_parser()
   : state_(method_start)
+  , content_length_(0)
+  , content_received_(0)
+  , chunk_remaining_(0)
+  , max_chunk_size_(default_max_chunk_size)
+  , max_body_size_(default_max_body_size)
+  , header_index_(0)
+  , header_filter_(nullptr)
+  , error_(request_error::malformed_request)
 { }
 
 void request_parser::reset() {
     state_ = method_start;
     last_method = "";
     last_header_name = "";
+    header_index_ = 0;
+    content_length_ = 0;
+    content_received_ = 0;
+    chunk_remaining_ = 0;
+    error_ = request_error::malformed_request;
+}
+
+void request_parser::set_max_chunk_size(std::size_t size) {
+    max_chunk_size_ = size;
+}
+
+void request_parser::set_max_body_size(std::size_t size) {
+    max_body_size_ = size;
+}
+
+void request_parser::set_header_filter(const header_filter* filter) {
+    header_filter_ = filter;
+}
+
+void request_parser::on_body_start(std::function<void(request<std::string>&)> handler) {
+    body_start_handler_ = std::move(handler);
+}
+
+void request_parser::append_body(request<std::string>& req, std::string_view chunk) {
+    content_received_ += chunk.size();
+
+    if (req.body_stream) {
+        req.body_stream.write(chunk);
+    } else {
+        req.body.append(chunk);
+    }
+}
+
+std::size_t request_parser::consume_run(request<std::string>& req, const char* begin, const char* end) {
+  switch (state_) {
+  case method:
+  case header_name:
+  {
+    const auto run_end = std::find_if_not(begin,
+        find_run_end(begin, end, state_ == method ? ' ' : ':', true), is_token);
+    /* anything else than the delimiter (e.g. a tspecial) is left for consume() to reject */
+    (state_ == method ? last_method : last_header_name).append(begin, run_end);
+    return static_cast<std::size_t>(run_end - begin);
+  }
+  case uri:
+  {
+    const auto run_end = find_run_end(begin, end, ' ', false);
+    req.path.append(begin, run_end);
+    return static_cast<std::size_t>(run_end - begin);
+  }
+  case header_value:
+  {
+    const auto run_end = find_run_end(begin, end, '\r', false);
+    if (run_end != begin && header_index_ != skipped_header) {
+      req.headers.value_at(header_index_).append(begin, run_end);
+    }
+    return static_cast<std::size_t>(run_end - begin);
+  }
+  default:
+    return 0;
+  }
+}
+
+void request_parser::split_query(request<std::string>& req) {
+  const auto question_mark = req.path.find('?');
+  if (question_mark != std::string::npos) {
+    req.query.assign(req.path, question_mark + 1);
+    req.path.resize(question_mark);
+  }
+}
+
+std::optional<std::size_t> request_parser::parse_view(request_view& req, std::string_view input, const header_filter* filter, std::size_t max_body_size) {
+  const char* const begin = input.data();
+  const char* const end = begin + input.size();
+  const char* position = begin;
+
+  /* Run of bytes accepted by find_run_end, followed by the expected delimiter */
+  const auto take_until = [&] (char delimiter, bool is_token_run) -> std::optional<std::string_view> {
+    const char* run_end = find_run_end(position, end, delimiter, is_token_run);
+    if (is_token_run) {
+      run_end = std::find_if_not(position, run_end, is_token);
+    }
+    if (run_end == end || *run_end != delimiter) {
+      return std::nullopt;
+    }
+    const std::string_view run(position, static_cast<std::size_t>(run_end - position));
+    position = run_end + 1;
+    return run;
+  };
+
+  const auto take = [&] (std::string_view expected) {
+    if (static_cast<std::size_t>(end - position) < expected.size() || std::string_view(position, expected.size()) != expected) {
+      return false;
+    }
+    position += expected.size();
+    return true;
+  };
+
+  const auto take_number = [&] (int& number) {
+    if (position == end || !is_digit(*position)) {
+      return false;
+    }
+    const auto [number_end, ec] = std::from_chars(position, end, number);
+    if (ec != std::errc() || number_end == position) {
+      return false;
+    }
+    position = number_end;
+    return true;
+  };
+
+  const auto method_name = take_until(' ', true);
+  if (!method_name || method_name->empty()) {
+    return std::nullopt;
+  }
+  const auto parsed_method = string_to_method(*method_name);
+  if (!parsed_method) {
+    return std::nullopt;
+  }
+
+  const auto path = take_until(' ', false);
+  if (!path) {
+    return std::nullopt;
+  }
+
+  req.method = *parsed_method;
+  req.path = *path;
+  req.query = { };
+  if (const auto question_mark = path->find('?'); question_mark != std::string_view::npos) {
+    req.path = path->substr(0, question_mark);
+    req.query = path->substr(question_mark + 1);
+  }
+  req.headers.clear();
+  req.body = { };
+
+  if (!take("HTTP/") || !take_number(req.http_version_major) || !take(".") || !take_number(req.http_version_minor) || !take("\r\n")) {
+    return std::nullopt;
+  }
+
+  while (!take("\r\n")) {
+    const auto name = take_until(':', true);
+    if (!name || name->empty() || !take(" ")) {
+      return std::nullopt;
+    }
+
+    const auto value = take_until('\r', false);
+    if (!value || !take("\n")) {
+      return std::nullopt;
+    }
+
+    /* obsolete line folding would need the value to be copied together */
+    if (position != end && (*position == ' ' || *position == '\t')) {
+      return std::nullopt;
+    }
+
+    if (!filter || filter->retains(*name)) {
+      req.headers.append(*name, *value);
+    }
+  }
+
+  if (req.headers.contains(known_header::transfer_encoding)) {
+    return std::nullopt;
+  }
+
+  if (req.headers.contains(known_header::content_length)) {
+    const auto length = req.headers.content_length();
+    /* too large body is rejected by parse() */
+    if (!length || *length > max_body_size || static_cast<std::size_t>(end - position) < *length) {
+      return std::nullopt;
+    }
+
+    req.body = std::string_view(position, *length);
+    position += *length;
+  }
+
+  return static_cast<std::size_t>(position - begin);
 }
 
 boost::tribool request_parser::consume(request<std::string>& req, char input) {
   switch (state_) {
   case method_start:
     if (!is_char(input) || is_ctl(input) || is_tspecial(input)) {
-        std::cout << "wrong method start\n";
       return false;
     } else {
       state_ = method;
@@ -27,8 +292,13 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
     }
   case method:
     if (input == ' ') {
+      const auto parsed_method = string_to_method(last_method);
+      if (!parsed_method) {
+        error_ = request_error::method_not_implemented;
+        return false;
+      }
       state_ = uri;
-        req.method = string_to_method(last_method).value();
+      req.method = *parsed_method;
       return boost::indeterminate;
     } else if (!is_char(input) || is_ctl(input) || is_tspecial(input)) {
       return false;
@@ -39,6 +309,7 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
   case uri:
     if (input == ' ') {
       state_ = http_version_h;
+      split_query(req);
       return boost::indeterminate;
     } else if (is_ctl(input)) {
       return false;
@@ -133,7 +404,7 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
       state_ = expecting_newline_3;
       return boost::indeterminate;
     }
-    else if (!req.headers.empty() && (input == ' ' || input == '\t'))
+    else if (!last_header_name.empty() && (input == ' ' || input == '\t'))
     {
       state_ = header_lws;
       return boost::indeterminate;
@@ -165,7 +436,8 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
     else
     {
       state_ = header_value;
-      req.headers[last_header_name].push_back(input);
+      if (header_index_ != skipped_header)
+        req.headers.value_at(header_index_).push_back(input);
       return boost::indeterminate;
     }
   case header_name:
@@ -186,7 +458,10 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
   case space_before_header_value:
     if (input == ' ')
     {
-        req.headers[last_header_name] = "";
+      /* headers nobody reads are parsed but not stored */
+      header_index_ = !header_filter_ || header_filter_->retains(last_header_name)
+          ? req.headers.start(last_header_name)
+          : skipped_header;
       state_ = header_value;
       return boost::indeterminate;
     }
@@ -206,12 +481,15 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
     }
     else
     {
-      req.headers[last_header_name].push_back(input);
+      if (header_index_ != skipped_header)
+        req.headers.value_at(header_index_).push_back(input);
       return boost::indeterminate;
     }
   case expecting_newline_2:
     if (input == '\n')
     {
+      if (header_index_ != skipped_header)
+        req.headers.complete(header_index_);
       state_ = header_line_start;
       return boost::indeterminate;
     }
@@ -224,20 +502,179 @@ boost::tribool request_parser::consume(request<std::string>& req, char input) {
         return false;
     }
 
-    if (req.headers.find("Content-Length") == req.headers.end() or std::stoul(req.headers["Content-Length"]) == 0) {
+    /* Transfer-Encoding takes precedence over Content-Length */
+    if (req.headers.contains(known_header::transfer_encoding)) {
+        /* several codings headers or a Content-Length next to them frame the body ambiguously, a proxy in
+           front may have read it differently (request smuggling) */
+        if (req.headers.count(known_header::transfer_encoding) != 1 || req.headers.contains(known_header::content_length)) {
+            error_ = request_error::malformed_request;
+            return false;
+        }
+
+        if (!is_chunked(req)) {
+            error_ = request_error::transfer_coding_not_implemented;
+            return false;
+        }
+
+        if (body_start_handler_) {
+            body_start_handler_(req);
+        }
+
+        state_ = chunk_size_start;
+        return boost::indeterminate;
+    }
+
+    /* Content-Length is already parsed, it's invalid if it's present but couldn't be */
+    if (req.headers.contains(known_header::content_length) and not req.headers.content_length()) {
+        error_ = request_error::invalid_content_length;
+        return false;
+    }
+
+    if (req.headers.content_length().value_or(0) == 0) {
         return true;
     }
 
-    req.body.reserve(std::stoul(req.headers["Content-Length"]));
+    content_length_ = *req.headers.content_length();
+
+    if (content_length_ > max_body_size_) {
+        error_ = request_error::payload_too_large;
+        return false;
+    }
+
+    if (body_start_handler_) {
+        body_start_handler_(req);
+    }
+
+    if (not req.body_stream) {
+        req.body.reserve(content_length_);
+    }
 
     state_ = content;
     return boost::indeterminate;
   case content:
-        req.body.push_back(input);
-        if (std::stoul(req.headers["Content-Length"]) == req.body.size()) {
+        append_body(req, std::string_view(&input, 1));
+        if (content_received_ == content_length_) {
             return true;
         }
         return boost::indeterminate;
+  case chunk_size_start:
+    if (hex_value(input) < 0)
+    {
+      return false;
+    }
+    chunk_remaining_ = static_cast<std::size_t>(hex_value(input));
+    if (chunk_remaining_ > max_chunk_size_) {
+      error_ = request_error::payload_too_large;
+      return false;
+    }
+    state_ = chunk_size;
+    return boost::indeterminate;
+  case chunk_size:
+    if (hex_value(input) >= 0)
+    {
+      const auto digit = static_cast<std::size_t>(hex_value(input));
+      /* chunk_remaining_ * 16 + digit <= max_chunk_size_, without wrapping around for limits below 16 */
+      if (digit > max_chunk_size_ || chunk_remaining_ > (max_chunk_size_ - digit) / 16) {
+        error_ = request_error::payload_too_large;
+        return false;
+      }
+      chunk_remaining_ = chunk_remaining_ * 16 + digit;
+      return boost::indeterminate;
+    }
+    else if (input == ';' || input == ' ' || input == '\t')
+    {
+      state_ = chunk_extension;
+      return boost::indeterminate;
+    }
+    else if (input == '\r')
+    {
+      state_ = chunk_size_newline;
+      return boost::indeterminate;
+    }
+    else
+    {
+      return false;
+    }
+  case chunk_extension:
+    /* chunk extensions are ignored */
+    if (input == '\r')
+    {
+      state_ = chunk_size_newline;
+      return boost::indeterminate;
+    }
+    else if (is_ctl(input) && input != '\t')
+    {
+      return false;
+    }
+    else
+    {
+      return boost::indeterminate;
+    }
+  case chunk_size_newline:
+    if (input != '\n')
+    {
+      return false;
+    }
+    if (chunk_remaining_ > max_body_size_ - content_received_)
+    {
+      error_ = request_error::payload_too_large;
+      return false;
+    }
+    state_ = chunk_remaining_ == 0 ? chunk_trailer_start : chunk_data;
+    return boost::indeterminate;
+  case chunk_data:
+    append_body(req, std::string_view(&input, 1));
+    if (--chunk_remaining_ == 0)
+    {
+      state_ = chunk_data_cr;
+    }
+    return boost::indeterminate;
+  case chunk_data_cr:
+    if (input != '\r')
+    {
+      return false;
+    }
+    state_ = chunk_data_newline;
+    return boost::indeterminate;
+  case chunk_data_newline:
+    if (input != '\n')
+    {
+      return false;
+    }
+    state_ = chunk_size_start;
+    return boost::indeterminate;
+  case chunk_trailer_start:
+    if (input == '\r')
+    {
+      state_ = chunk_end_newline;
+      return boost::indeterminate;
+    }
+    else if (is_ctl(input))
+    {
+      return false;
+    }
+    /* trailer fields are skipped */
+    state_ = chunk_trailer;
+    return boost::indeterminate;
+  case chunk_trailer:
+    if (input == '\r')
+    {
+      state_ = chunk_trailer_newline;
+    }
+    return boost::indeterminate;
+  case chunk_trailer_newline:
+    if (input != '\n')
+    {
+      return false;
+    }
+    state_ = chunk_trailer_start;
+    return boost::indeterminate;
+  case chunk_end_newline:
+    if (input != '\n')
+    {
+      return false;
+    }
+    return true;
   default:
     return false;
   }
@@ -272,4 +709,29 @@ bool request_parser::is_digit(int c)
   return c >= '0' && c <= '9';
 }
 
+int request_parser::hex_value(int c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+bool request_parser::is_chunked(const request<std::string>& req)
+{
+  /* chunked has to be the only coding, bodies with other codings (gzip, ...) can't be decoded */
+  std::string_view coding = req.headers.at(known_header::transfer_encoding);
+  while (!coding.empty() && (coding.front() == ' ' || coding.front() == '\t'))
+    coding.remove_prefix(1);
+  while (!coding.empty() && (coding.back() == ' ' || coding.back() == '\t'))
+    coding.remove_suffix(1);
+
+  constexpr std::string_view chunked = "chunked";
+  return std::equal(coding.begin(), coding.end(), chunked.begin(), chunked.end(),
+      [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+}
+
 } // namespace fhttp
\ No newline at end of file
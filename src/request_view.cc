@@ -0,0 +1,45 @@
+#include <fhttp/request_view.h>
+
+namespace fhttp {
+
+std::optional<std::string_view> request_view::header(std::string_view name) const {
+    return headers.get(name);
+}
+
+fhttp::cookies request_view::cookies() const {
+    return fhttp::cookies { headers.get(known_header::cookie).value_or(std::string_view { }) };
+}
+
+request<std::string> request_view::to_request() const {
+    request<std::string> req { };
+    req.method = method;
+    req.path = path;
+    req.query = query;
+    req.http_version_major = http_version_major;
+    req.http_version_minor = http_version_minor;
+    for (const auto& [key, value] : headers) {
+        req.headers.append(std::string { key }, std::string { value });
+    }
+    req.body = body;
+    /* still views of this request's path, those stay valid as long as the view does */
+    req.path_params = path_params;
+    req.arena = arena;
+
+    return req;
+}
+
+request_view view_of(const request<std::string>& req) {
+    request_view view { };
+    view.method = req.method;
+    view.path = req.path;
+    view.query = req.query;
+    view.http_version_major = req.http_version_major;
+    view.http_version_minor = req.http_version_minor;
+    view.headers = header_view_map::view_of(req.headers);
+    view.body = req.body;
+    view.path_params = req.path_params;
+    view.arena = req.arena;
+    return view;
+}
+
+} // namespace fhttp
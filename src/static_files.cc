@@ -0,0 +1,97 @@
+#include <fhttp/static_files.h>
+#include <fhttp/range.h>
+
+#include <random>
+
+namespace fhttp {
+
+namespace {
+
+/// @brief If-Range is satisfied only by an exact (strong) ETag match or the exact Last-Modified date
+bool is_if_range_fresh(std::optional<std::string_view> if_range, const cached_file& file) {
+    if (not if_range) {
+        return true;
+    }
+
+    if (if_range->starts_with("W/")) {
+        return false;
+    }
+    return *if_range == file.etag or *if_range == file.last_modified;
+}
+
+std::string make_boundary() {
+    thread_local std::mt19937_64 generator { std::random_device { }() };
+
+    std::string boundary = "fhttp-";
+    detail::append_hex_number(boundary, generator());
+    return boundary;
+}
+
+std::string content_range(const byte_range& range, std::size_t size) {
+    std::string value = "bytes ";
+    detail::append_number(value, range.offset);
+    value.push_back('-');
+    detail::append_number(value, range.offset + range.length - 1);
+    value.push_back('/');
+    detail::append_number(value, size);
+    return value;
+}
+
+} // namespace
+
+void serve_file(std::optional<std::string_view> range_header, std::optional<std::string_view> if_range, response<std::string>& resp, std::shared_ptr<const cached_file> file) {
+    resp.headers[HEADER_ACCEPT_RANGES] = "bytes";
+    resp.headers[HEADER_ETAG] = file->etag;
+    resp.headers[HEADER_LAST_MODIFIED] = file->last_modified;
+
+    range_request range { };
+    if (range_header and is_if_range_fresh(if_range, *file)) {
+        range = parse_range(*range_header, file->size);
+    }
+    const auto& ranges = range.ranges;
+
+    if (range.status == range_status::none) {
+        resp.status_code = STATUS_CODE_OK;
+        resp.headers[HEADER_CONTENT_TYPE] = file->content_type;
+        resp.body_file = file_region { file, 0, file->size };
+        return;
+    }
+
+    if (range.status == range_status::unsatisfiable) {
+        std::string value = "bytes */";
+        detail::append_number(value, file->size);
+
+        resp.status_code = STATUS_CODE_RANGE_NOT_SATISFIABLE;
+        resp.headers[HEADER_CONTENT_RANGE] = std::move(value);
+        return;
+    }
+
+    resp.status_code = STATUS_CODE_PARTIAL_CONTENT;
+
+    if (ranges.size() == 1) {
+        resp.headers[HEADER_CONTENT_TYPE] = file->content_type;
+        resp.headers[HEADER_CONTENT_RANGE] = content_range(ranges.front(), file->size);
+        resp.body_file = file_region { file, ranges.front().offset, ranges.front().length };
+        return;
+    }
+
+    /* multipart/byteranges, part headers go out from memory, part data still with sendfile */
+    const auto boundary = make_boundary();
+    resp.headers[HEADER_CONTENT_TYPE] = "multipart/byteranges; boundary=" + boundary;
+
+    file_body body { };
+    body.parts.reserve(ranges.size() + 1);
+    for (const auto& range : ranges) {
+        std::string prefix { };
+        prefix.append("\r\n--").append(boundary).append("\r\n");
+        prefix.append(HEADER_CONTENT_TYPE).append(": ").append(file->content_type).append("\r\n");
+        prefix.append(HEADER_CONTENT_RANGE).append(": ").append(content_range(range, file->size)).append("\r\n\r\n");
+
+        body.parts.push_back({ std::move(prefix), file_region { file, range.offset, range.length } });
+    }
+    body.parts.push_back({ "\r\n--" + boundary + "--\r\n", file_region { } });
+
+    resp.body_file = std::move(body);
+}
+
+} // namespace fhttp
@@ -0,0 +1,112 @@
+#include <fhttp/streaming_body.h>
+#include <fhttp/buffer_pool.h>
+#include <fhttp/logging.h>
+
+namespace fhttp {
+
+streaming_body::streaming_body(std::size_t spill_threshold)
+    : state { std::make_shared<body_state>() }
+{
+    state->spill_threshold = spill_threshold;
+}
+
+void streaming_body::on_chunk(chunk_handler_t handler) {
+    state->chunk_handler = std::move(handler);
+}
+
+void streaming_body::write(std::string_view chunk) {
+    state->size += chunk.size();
+
+    if (state->chunk_handler) {
+        state->chunk_handler(chunk);
+        return;
+    }
+
+    /* rest of a body that couldn't be stored is dropped, the request is answered with an error anyway */
+    if (state->is_failed) {
+        return;
+    }
+
+    if (not state->spill_file and state->memory.size() + chunk.size() > state->spill_threshold) {
+        state->spill_file.reset(std::tmpfile());
+        if (not state->spill_file) {
+            FHTTP_LOG(WARNING) << "Failed to create temporary file for request body, keeping it in memory";
+        } else {
+            /* unbuffered, so a failed write (full disk) shows up in fwrite's result rather than at some later flush */
+            std::setvbuf(state->spill_file.get(), nullptr, _IONBF, 0);
+            if (std::fwrite(state->memory.data(), 1, state->memory.size(), state->spill_file.get()) != state->memory.size()) {
+                fail();
+                return;
+            }
+            std::string { }.swap(state->memory);
+        }
+    }
+
+    if (state->spill_file) {
+        if (std::fwrite(chunk.data(), 1, chunk.size(), state->spill_file.get()) != chunk.size()) {
+            fail();
+        }
+    } else {
+        state->memory.append(chunk);
+    }
+}
+
+void streaming_body::fail() {
+    FHTTP_LOG(WARNING) << "Failed to write request body to its temporary file (disk full?)";
+    state->is_failed = true;
+    state->spill_file.reset();
+    std::string { }.swap(state->memory);
+}
+
+bool streaming_body::is_failed() const {
+    return state and state->is_failed;
+}
+
+std::size_t streaming_body::size() const {
+    return state ? state->size : 0;
+}
+
+bool streaming_body::is_spilled() const {
+    return state and state->spill_file;
+}
+
+bool streaming_body::read(const chunk_handler_t& handler) const {
+    if (not state) {
+        return true;
+    }
+
+    if (state->is_failed) {
+        return false;
+    }
+
+    if (not state->spill_file) {
+        if (not state->memory.empty()) {
+            handler(state->memory);
+        }
+        return true;
+    }
+
+    auto* file = state->spill_file.get();
+    std::fflush(file);
+    std::rewind(file);
+
+    auto buffer = buffer_pool::local().lease(buffer_pool::max_buffer_size);
+    while (const auto n = std::fread(buffer.data(), 1, buffer.size(), file)) {
+        handler({ buffer.data(), n });
+    }
+
+    const bool ok = not std::ferror(file);
+    std::fseek(file, 0, SEEK_END);
+    return ok;
+}
+
+std::string streaming_body::to_string() const {
+    std::string out { };
+    out.reserve(size());
+    read([&out] (std::string_view chunk) {
+        out.append(chunk);
+    });
+    return out;
+}
+
+} // namespace fhttp
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string_view>
+
+/* Text helpers shared by the translation units of the library, not part of its interface */
+
+namespace fhttp {
+
+namespace detail {
+
+/// @brief `value` without leading & trailing spaces and tabs (optional whitespace of HTTP)
+inline std::string_view trim(std::string_view value) {
+    while (not value.empty() and (value.front() == ' ' or value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (not value.empty() and (value.back() == ' ' or value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+} // namespace detail
+
+} // namespace fhttp